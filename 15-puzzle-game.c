@@ -2,16 +2,23 @@
 #include <math.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 /* Mode */
 #define INT_DISABLE           0b11000000
 #define INT_ENABLE            0b01000000
 #define IRQ_MODE              0b10010
 #define SVC_MODE              0b10011
 #define TIMER_BASE            0xFF202000	
+#define TIMER_CLOCK_HZ        100000000     // interval timer input clock
+#define TIMER_PERIOD          100000000     // cycles per timer interrupt (1 sec)
+#define TIMER_CYCLES_PER_MS   (TIMER_CLOCK_HZ/1000)
+#define TIMER_MS_PER_PERIOD   (TIMER_PERIOD/TIMER_CYCLES_PER_MS)
 /* Memory */
 #define A9_ONCHIP_END         0xFFFFFFFF
 /* Cyclone V FPGA Device */
 #define PS2_BASE              0xFF200100
+#define PS2_DUAL_BASE         0xFF200108    // second PS/2 port, used for the mouse
+#define SW_BASE               0xFF200040    // slide switches, SW9-0 is the player tag
 /* Interrupt controller (GIC) CPU interface(s) */
 #define MPCORE_GIC_CPUIF      0xFFFEC100    // PERIPH_BASE + 0x100
 #define ICCICR                0x00          // offset to CPU interface control reg
@@ -23,19 +30,276 @@
 #define ICDDCR                0x00          // offset to distributor control reg
 /* Keyboard related Variables */
 #define PS2_IRQ 			  79            // Interrupt ID
-#define PS2_L_ARROW           0x6B
+#define PS2_L_ARROW           0x6B          // arrows and Home follow 0xE0
 #define PS2_R_ARROW           0x74
+#define PS2_UP_ARROW          0x75
+#define PS2_DOWN_ARROW        0x72
 #define PS2_BACKSPACE         0x66
 #define PS2_ENTER             0x5A
+#define PS2_W                 0x1D
+#define PS2_A                 0x1C
+#define PS2_S                 0x1B
+#define PS2_D                 0x23
+#define PS2_Q                 0x15
+#define PS2_E                 0x24
+#define PS2_H                 0x33
+#define PS2_M                 0x3A
+#define PS2_U                 0x3C
+#define PS2_R                 0x2D
+#define PS2_K                 0x42
+#define PS2_N                 0x31
+#define PS2_HOME              0x6C
+/* Key actions, the slides share their numbers with the move_offset directions */
+#define ACTION_SLIDE_UP       0             // the tile below the no tile moves up
+#define ACTION_SLIDE_LEFT     1
+#define ACTION_SLIDE_DOWN     2
+#define ACTION_SLIDE_RIGHT    3
+#define ACTION_SELECT_NEXT    4             // selection clockwise
+#define ACTION_SELECT_PREV    5             // selection counterclockwise
+#define ACTION_MOVE           6             // slide the selected tile
+#define ACTION_SHUFFLE        7
+#define ACTION_HINT           8             // moves the selection to the hinted tile
+#define ACTION_DEMO           9             // starts the demo, any key stops it
+#define ACTION_UNDO           10
+#define ACTION_REDO           11
+#define ACTION_REWIND         12            // back to the start of the board
+#define ACTION_REBIND         13            // next key picks a binding, the one after replaces its key
+#define ACTION_PROFILE_DUMP   14
+#define ACTION_NEXT_MODE      15            // switch to the next game mode and start over
+/* Mouse related Variables */
+#define PS2_DUAL_IRQ          89            // Interrupt ID
+#define MOUSE_RESET           0xFF
+#define MOUSE_ENABLE          0xF4          // enable data reporting
+#define MOUSE_ACK             0xFA
+#define MOUSE_SELF_TEST_OK    0xAA
+#define SCREEN_WIDTH          320
+#define SCREEN_HEIGHT         240
+#define CURSOR_SIZE           8
 /* Game variables */
 #define NO_TILE               -1
 #define TILE_dimension        3
+#define SELECTABLE_MAX        (2*(TILE_dimension-1)) // tiles in the no tile's row and column
+#define BOARD_STATS_CHECK     0             // set to 1 to verify incremental stats after every move
+#define BOARD_VALID           0
+#define BOARD_UNSOLVABLE      1             // repaired by new_game_board()
+#define BOARD_MALFORMED       2             // not every tile exactly once, rejected
+#define NO_BOARD              -1            // board_number of a board not from the corpus, kept off the leaderboard
+#define HINT_CACHE_BITS       6             // hint cache holds 2^6 boards
+#define HINT_FOUND            -1
+#define HINT_NOT_FOUND        1000000       // larger than any f value of the search
+#define SOLUTION_MAX_MOVES    81            // longest optimal solution up to 4x4
+#define SOLVER_WEIGHT         10            // weight of h in tenths, 10 is optimal, up to 20 is faster with longer solutions
+#define TT_ENABLED            1             // skip states IDA* already reached with fewer moves in the same iteration
+#define TT_BUCKET_BITS        12            // 4096 buckets of 4 entries, 256 KB
+#define TT_BUCKET_ENTRIES     4
+#define BIBFS_ENABLED         0             // set to 1 to try a bidirectional BFS before IDA*
+#define BIBFS_MAX_NODES       65536         // states kept per direction, past this solve_board() uses IDA*
+#define BIBFS_HASH_BITS       17            // hash slots per direction, twice the node cap
+#define BIBFS_GENERATIONS     (1 << (32 - BIBFS_HASH_BITS))
+#define PDB_ENABLED           0             // set to 1 to add a pattern database to the solver's manhattan distance
+#define PDB_TILES             5             // the pattern is the no tile and tiles 1..5
+#define PDB_CELLS             (TILE_dimension*TILE_dimension)
+#define PDB_ENTRIES           (PDB_CELLS*(PDB_CELLS-1)*(PDB_CELLS-2)*(PDB_CELLS-3)*(PDB_CELLS-4)*(PDB_CELLS-5))
+#define PDB_BITS              2             // bits per entry, 2 stores the distance mod 3, 4 the distance capped at 14
+#define PDB_EMPTY             ((1 << PDB_BITS) - 1) // not reached yet, 4 bit distances are capped below it
+#define HINT_TABLE_ENABLED    (TILE_dimension == 3) // exact distance of every board, built in the background
+#define HINT_TABLE_ENTRIES    362880        // 9!, indexed by board_rank()
+#define HINT_TABLE_EMPTY      3             // unsolvable, or not reached yet
+#define HINT_TABLE_FRAME_MS   4             // time hint_table_step() may take per pass of the main loop
+#define BENCHMARK_ENABLED     0             // set to 1 to time the solver on a fixed set of boards at startup
+#define BENCHMARK_BOARDS      100
+#define BENCHMARK_SEED        100           // random_board() seed, the same boards every run
+#define LAYER_STATS_ENABLED   0             // set to 1 to count the boards at each distance in the background, 3x3 only
+#define LAYER_MAX_STATES      32768         // largest layer kept, the 3x3 peak is 24047 boards at distance 24
+#ifndef MAX_SESSIONS
+#define MAX_SESSIONS          4             // game_session slots in the pool, host tools build with more
+#endif
+#define MAX_SOLVERS           2             // solver slots in the pool
+#define HISTORY_MAX_MOVES     512           // 2 bits per move
+#define HISTORY_CHECKPOINT    64            // moves between saved boards
+#define HISTORY_CHECKPOINTS   (HISTORY_MAX_MOVES/HISTORY_CHECKPOINT)
+/* Game modes */
+#define MODE_TIMED            0             // the original 3 minute game
+#define MODE_UNTIMED          1
+#define MODE_MOVE_LIMIT       2
+#define MODE_COUNTDOWN        3
+#define MODE_MARATHON         4
+#define GAME_MODES            5
+#define GAME_MODE_DEFAULT     MODE_TIMED
+#define NO_LIMIT              0
+/* Board corpus */
+#define CORPUS_MAGIC          0x35315043    // "CP15"
+#define CORPUS_BUCKETS        4             // difficulty buckets, the last one is open ended
+#define CORPUS_BUCKET_MOVES   8             // optimal moves covered by each bucket
+#define CORPUS_START_DIFFICULTY 1           // the first game is drawn from this bucket
+/* Leaderboard */
+#define LEADERBOARD_BOARDS    11            // corpus boards with a leaderboard, from index 0
+#define LEADERBOARD_TOP       5             // scores kept per board
+#define SCORE_LOG_SIZE        128           // records before the log is compacted, more than BOARDS*TOP
+#define SCORE_CHECK_SEED      0x15A5        // keeps an all zero record from passing the checksum
+#define SCORE_NO_BOARD        0xFFFF        // board of a free slot, leaderboard_load() stops there
+#define SCORE_STORE_BASE      0x3E000000    // SDRAM the C startup code never clears, well below the stack
+#define SCORE_STORE_MAGIC     0x53434F52    // "SCOR", anything else is power on garbage and is formatted
+/* Demo mode */
+#define DEMO_MOVE_MS          600           // delay between moves played by the demo
+#define DEMO_BOARD_PAUSE_MS   2000          // delay after a board is solved
+#define DEMO_IDLE_MS          60000         // start the demo after a finished game sits this long without input
+/* Profiling (set PROFILE_ENABLED to 1 to compile in the latency probes) */
+#define PROFILE_ENABLED       0
+#define MPCORE_PRIV_TIMER     0xFFFEC600    // A9 private timer, counts down at 200 MHz
+#define PS2_P                 0x4D          // bound to ACTION_PROFILE_DUMP
+#define PROFILE_RING_SIZE     256           // must be a power of 2
+#define PROFILE_BUCKETS       124           // 4 sub-buckets per power of 2 up to 2^32
+#define PROF_PS2_ISR          0
+#define PROF_TIMER_ISR        1
+#define PROF_SWAP_TILE        2
+#define PROF_FRAME            3
+#define PROF_NUM_PROBES       4
+
+#if PROFILE_ENABLED
+// record the private timer value at the start of a probed section
+#define PROFILE_BEGIN()       unsigned int prof_start = read_cycle_counter()
+// push (probe, elapsed cycles) into the ring buffer
+#define PROFILE_END(id)       profile_record(id, prof_start - read_cycle_counter())
+#else
+#define PROFILE_BEGIN()
+#define PROFILE_END(id)
+#endif
+
+// board corpus image: a header followed by count records sorted by
+// difficulty, bucket b holds records bucket_start[b] to bucket_start[b+1]-1
+struct corpus_header {
+    unsigned int magic;
+    unsigned char board_size; // TILE_dimension the corpus was made for
+    unsigned char buckets;
+    unsigned short reserved;
+    unsigned int count;
+    unsigned int bucket_start[CORPUS_BUCKETS + 1];
+};
+
+// board packed as board_key() does, 4 bits per cell with 0 for the no tile
+struct corpus_record {
+    unsigned long long board;
+    unsigned char optimal_moves;
+    unsigned char difficulty; // optimal_moves / CORPUS_BUCKET_MOVES, capped
+} __attribute__((packed));
+
+// transposition table entry, only entries of the current IDA* iteration count
+struct tt_entry {
+    unsigned long long key; // board_key() of the state
+    unsigned int iteration;
+    unsigned short g; // fewest moves the state was reached with
+};
+
+// one cache line, a lookup never touches more than one
+struct tt_bucket {
+    struct tt_entry entries[TT_BUCKET_ENTRIES];
+} __attribute__((aligned(64)));
+
+// one state seen by the bidirectional search, parent is -1 for the root
+struct bibfs_node {
+    unsigned long long key; // board_key() of the state
+    int parent;
+    signed char blank;
+    unsigned char depth;
+};
+
+// one direction of the search, nodes are kept in the order they were found
+// so each level is a range of the array and no separate queue is needed
+struct bibfs_side {
+    struct bibfs_node nodes[BIBFS_MAX_NODES];
+    int count;
+    int level_start; // first node of the level to expand next
+    // generation << BIBFS_HASH_BITS | node index + 1, slots of older
+    // generations are empty so a new search does not have to clear the table
+    unsigned int hash[1 << BIBFS_HASH_BITS];
+    unsigned int generation;
+};
+
+// one finished game in the score log; board is written last so a record cut
+// short by a reset is dropped when the log is loaded
+struct score_record {
+    unsigned short board;
+    unsigned short moves;
+    unsigned int elapsed_ms;
+    unsigned short player; // SW9-0 when the game was won
+    unsigned short check;
+};
+
+// two score logs kept across resets at SCORE_STORE_BASE. A compaction fills
+// the log that is not active and then switches active, a single word, so a
+// reset at any point leaves either the old log or the new one
+struct score_store {
+    unsigned int magic;
+    unsigned int active; // 0 or 1, the log leaderboard_load() reads
+    struct score_record logs[2][SCORE_LOG_SIZE];
+};
+
+// limits of a game, a limit of NO_LIMIT is never reached
+struct game_mode {
+    char* name;
+    unsigned int time_limit_ms;
+    int move_limit;
+    bool countdown; // HEX3-0 shows the time left instead of the time played
+    int boards; // boards to solve in a row, the clock keeps running between them
+};
+
+// one entry of the keymap, extended keys are the ones sent after 0xE0
+struct key_binding {
+    unsigned char code;
+    bool extended;
+    signed char action;
+};
+
+// everything about one game: the board, the selection, the clock and the board
+// statistics. The VGA game is `game`, the logic functions take any session
+struct game_session {
+    int game_tile_positions[TILE_dimension*TILE_dimension];
+    int no_tile_position;
+    int selected_tile_position;
+    bool game_over;
+    int game_number; // board shuffle() loads next
+    int board_number; // board shuffle() loaded, the leaderboard key
+    int moves; // slides made, a whole row or column run counts as one
+    unsigned int start_ms; // system time the game started at
+    unsigned int end_ms; // system time the game clock was paused at
+    unsigned int deadline_ms; // system time the mode's time limit runs out at
+    volatile bool limit_reached; // set by session_move() and the timer ISR, cleared by game_clock_reset()
+    // board statistics, kept up to date in O(1) per move
+    int misplaced_tiles; // tiles not on their goal position
+    int manhattan_distance; // sum of tile_distance over all tiles
+    int linear_conflicts; // sum of row_conflicts and col_conflicts
+    int row_conflicts[TILE_dimension];
+    int col_conflicts[TILE_dimension];
+    int inversions; // pairs out of order in row major order, parity decides solvability
+    int keystrokes; // keys and clicks that did something, compared with moves on a win
+    // move history, the direction the no tile moved in (index into move_offset)
+    unsigned char history[HISTORY_MAX_MOVES/4];
+    unsigned char history_ends[HISTORY_MAX_MOVES/8]; // bit i set if tile move i finished a slide
+    int history_length; // moves that can be redone up to
+    int history_position; // moves currently applied
+    signed char checkpoints[HISTORY_CHECKPOINTS][TILE_dimension*TILE_dimension]; // board every HISTORY_CHECKPOINT moves
+    struct game_session* next_free; // free list link while the slot is unused
+};
+
+// a solved board and the moves left on its path. The search itself runs in
+// the shared hint_board, hint_key, solution_moves and tt_table, so a solve
+// allocates nothing but only one can run at a time; the contexts come from a
+// fixed pool like the sessions
+struct solver {
+    unsigned long long key; // board_key() of the board solver_next_move() expects next
+    int moves[SOLUTION_MAX_MOVES]; // tile position moved at each step
+    int length; // -1 if the board could not be solved
+    int next; // moves already handed out by solver_next_move()
+    struct solver* next_free;
+};
 
 // configuring interrupts
 void config_all_IRQ_interrupts(); // set all signals to configure interrupts
 void set_A9_IRQ_stack(); // initiate the stack pointer for IRQ mode
 void config_GIC(); // configure the general interrupt controller
 void config_PS2(); // configure PS2 to generate interrupts
+void config_mouse(); // configure the second PS2 port for the mouse
 void disable_A9_interrupts(); //turn off interrupts
 void enable_A9_interrupts(); // enable interrupts
 void config_interrupts(int N, int CPU_target);
@@ -43,9 +307,28 @@ void shuffle();
 void counter();
 void config_interval_timer(); // configure Altera interval timer to generate
 
+// game clock
+unsigned int system_clock_ms(); // milliseconds since the interval timer started
+unsigned int game_clock_ms(struct game_session* s); // milliseconds played in the game
+void game_clock_reset(struct game_session* s); // start timing a new game from 0
+void game_clock_pause(struct game_session* s); // freeze the game clock once the game is over
+
 // Interrupt Service Routine
 void PS2_ISR();
 void interval_timer_ISR();
+void mouse_ISR();
+
+// keymap
+void key_released(int code, bool extended); // decoded break code, runs the bound action
+int keymap_lookup(int code, bool extended); // index into keymap, -1 if the key is unbound
+void keymap_rebind(int code, bool extended); // steps of ACTION_REBIND
+
+// mouse
+void mouse_packet(unsigned char packet[]); // decode one 3 byte movement packet
+void mouse_click(int x, int y); // slide the tile under the cursor
+void cursor_hide(); // put back the pixels under the cursor
+void cursor_show(); // save the pixels under the cursor and draw it
+short int read_pixel(int x, int y);
 
 // VGA
 void init_vga_buffer();
@@ -64,44 +347,390 @@ void plot_pixel(int x, int y, short int line_color);
 void animate_swap_tile();
 
 // keyboard tile selections
-void get_selectable_tiles(int* selectable_tiles, int* size, int* current_select_index);
+void get_selectable_tiles(struct game_session* s, int* selectable_tiles, int* size, int* current_select_index);
 bool is_tile_position_legal(int new_pos);
 void select_new_selected_tile(int direction_offset);
+void slide_tile(int direction); // slide the no tile's neighbour, direction as in move_offset
+void move_tile_at(int position); // select the tile and slide it
 void swap_tile();
 void reset_selected_tile();
 void drawing_png2(int i, int j, int array[], int value);
 
-// game logic
-void new_game_board(int array1[], int array2[]);
+// session pool, fixed slots recycled through a free list instead of malloc
+void session_pool_init();
+struct game_session* session_alloc(); // zeroed slot, NULL if the pool is empty
+void session_free(struct game_session* s);
+struct game_session* session_recycle(struct game_session* s); // new game in place of s
+
+// game logic, no drawing so any session can use it
+int new_game_board(struct game_session* s, int board[]); // BOARD_MALFORMED boards are not loaded
+bool session_move(struct game_session* s); // slide the selected tile, false if the game is over
+int slide_step(struct game_session* s); // offset from the no tile towards the selected tile
+int session_neighbour(struct game_session* s, int direction); // tile that slides in direction, NO_TILE at the edge
+void session_select(struct game_session* s, int direction_offset); // same as the arrow keys
+void session_reset_selection(struct game_session* s);
+bool session_limit_reached(struct game_session* s); // out of time or moves in the current mode, reads the flag only
+void session_check_deadline(struct game_session* s, unsigned int now_ms); // sets the flag once the time limit is up
+void session_apply(struct game_session* s, int position); // move a tile without recording it
+
+// move history
+void history_record(struct game_session* s, int from, int to);
+int history_direction(struct game_session* s, int index);
+bool history_slide_end(struct game_session* s, int index); // tile move index was the last of a slide
+int history_undo_tile(struct game_session* s); // tile whose run an undo slides back, NO_TILE if none
+int history_redo_tile(struct game_session* s);
+bool session_undo(struct game_session* s); // takes back a whole slide
+bool session_redo(struct game_session* s);
+void session_restore(struct game_session* s, int position); // jump to any point of the history
+void undo_tile(); // animated undo of the VGA game
+void redo_tile();
+void rewind_board(); // back to the board as it was shuffled
 void check_game_status();
 
+// game modes
+void game_mode_select(int mode_index); // takes effect from the next shuffle()
+void next_game_mode();
+
+// board statistics, kept up to date in O(1) per move
+int tile_distance(int tile, int position); // manhattan distance of tile from its goal
+void distance_table_init(); // tile_distance() for every tile and position, used by the solver
+int line_conflicts(struct game_session* s, int line, bool is_row); // tiles to move out of the line to fix its order
+void board_stats_recompute(struct game_session* s); // full scan, used for new boards
+void board_stats_update(struct game_session* s, int from, int to); // tile moved from -> to (old no tile position)
+int board_distance(struct game_session* s); // manhattan distance + linear conflicts, a lower bound on moves left
+bool board_is_solvable(struct game_session* s);
+
+// board validation, for any board before it is loaded
+int board_inversions(int board[]); // O(n log n) with a Fenwick tree over the tile numbers
+bool board_parity_solvable(int inversions, int no_tile_position);
+int board_validate(int board[]); // BOARD_VALID, BOARD_UNSOLVABLE or BOARD_MALFORMED
+void board_repair(int board[]); // swap two tiles, which flips the parity
+int boards_validate(int boards[], int count); // boards stored back to back, returns how many are valid
+
+// permutation ranking, a bijection between boards (or where some tiles are)
+// and the integers, for tables indexed by board
+unsigned long long permutation_rank(const int values[], int k); // k distinct values of 0..n-1, rank below n!/(n-k)!
+void permutation_unrank(unsigned long long rank, int values[], int k);
+unsigned long long board_rank(int board[]); // below n!, the no tile counts as 0
+void board_unrank(unsigned long long rank, int board[]);
+
+// hints
+unsigned long long board_key(int board[]); // packs a board into 4 bits per cell
+int key_hash(unsigned long long key, int bits); // slot of a board_key() in a table of 2^bits
+int board_neighbour(int blank, int direction); // cell the no tile moves to, NO_TILE off the board
+int hint_search(int blank, int prev_blank, int g, int bound, int h); // one IDA* iteration
+int solve_board(int board[]); // fills solution_moves for the board, returns its length
+int get_hint(struct game_session* s); // position of the tile to move next on the solver's path, NO_TILE if none
+void show_hint(); // move the selection frame to the hinted tile
+
+// solver library, for any board laid out like game_tile_positions; nothing
+// here touches the hardware, so host tools can link it too. It is single
+// threaded and not reentrant: a context only holds the path, every solve
+// searches in the same scratch state. The game never overlaps two, hints are
+// asked for from PS2_ISR outside the demo and the demo solves from the main loop
+void solver_pool_init();
+struct solver* solver_create(); // NULL if the pool is empty
+void solver_destroy(struct solver* solver);
+int solver_solve(struct solver* solver, int board[]); // moves to the goal, -1 if the board is malformed or unsolvable
+int solver_next_move(struct solver* solver, int board[]); // position of the tile to move, NO_TILE if solved or unsolvable
+int solver_distance(struct solver* solver, int board[]); // moves left on the solver's path, -1 if unsolvable
+
+// board corpus
+bool corpus_open(const struct corpus_header* header); // maps an image already in memory
+void corpus_board(int index, int board[]); // unpacks a record into board
+int corpus_pick(int difficulty); // random record of a difficulty bucket, -1 if it has none
+
+// transposition table
+#if TT_ENABLED
+bool tt_visit(unsigned long long key, int g); // false if the state was already reached with g or fewer moves
+#endif
+
+// bidirectional solver, meets in the middle between the board and the goal
+#if BIBFS_ENABLED
+int solve_board_bidirectional(int board[], int no_tile_position); // fills solution_moves, -1 past the node cap
+int bibfs_find(struct bibfs_side* side, unsigned long long key); // node index, -1 if not seen
+int bibfs_add(struct bibfs_side* side, unsigned long long key, int parent, int blank); // -1 if the side is full
+#endif
+
+// pattern database, PDB_BITS per entry indexed by permutation_rank() of the
+// pattern's positions with the no tile first
+#if PDB_ENABLED
+void pdb_init(); // breadth-first from the goal pattern
+int pdb_get(unsigned int rank); // stored value, PDB_EMPTY if not reached
+void pdb_set(unsigned int rank, int distance);
+void pdb_pattern(int board[], int pattern[]); // positions of the no tile and tiles 1..PDB_TILES
+void pdb_move(int pattern[], int position); // the no tile moves to position, twice is undone
+int pdb_distance(int pattern[]); // walks down to the goal when only the distance mod 3 is stored, manhattan if the table is not built
+int pdb_child_distance(int distance, unsigned int child_rank); // for a state one move from one at distance
+#endif
+
+// hint table, 2 bits per board holding its distance mod 3
+#if HINT_TABLE_ENABLED
+void hint_table_init(); // the goal only, hint_table_step() fills in the rest
+bool hint_table_step(); // one slice of the breadth-first fill, false once the table is complete
+int hint_table_get(unsigned int rank);
+void hint_table_set(unsigned int rank, int distance);
+int hint_table_advance(int board[]); // makes the move, returns the position the tile came from
+int hint_table_move(int board[]); // position of the tile to move on a shortest path, NO_TILE if solved
+int hint_table_distance(int board[]); // exact moves to the goal, the board must be solvable
+#endif
+
+// solver benchmark, a table and a JSON line on the terminal
+#if BENCHMARK_ENABLED
+void solver_benchmark();
+#endif
+
+// layer statistics, the exact number of boards at each distance from the goal
+#if LAYER_STATS_ENABLED
+void layer_stats_start(); // layer 0 is the goal
+bool layer_stats_step(); // expands one layer, false once every board is counted
+int compare_keys(const void* a, const void* b);
+#endif
+
+// leaderboard, an append-only score log with a top-N index per board
+void leaderboard_load(); // rebuild the index from the log, stops at the first bad record
+bool leaderboard_append(int board, int moves, unsigned int elapsed_ms, int player);
+void leaderboard_insert(int record); // place a log record in its board's top-N
+void leaderboard_compact(); // drop every record that is out of the top-N, into the other log
+int leaderboard_top(int board, struct score_record* scores[], int n); // best n scores, returns how many
+unsigned short score_checksum(struct score_record* r);
+void leaderboard_print(int board);
+
+// demo mode
+void demo_step(); // called from the main loop, plays the next move when it is due
+void demo_start();
+void demo_next_board(); // random solvable board, solved before it is shown
+void random_board(int board[]);
+
 // debug; pass 16 for unused num
 void display_on_hex(int num_a, int num_b, int num_c, int num_d, int num_e, int num_f);
+
+// profiling
+#if PROFILE_ENABLED
+void config_private_timer(); // free running cycle counter used by the probes
+unsigned int read_cycle_counter();
+void profile_record(int probe, unsigned int cycles);
+void profile_drain(); // move samples from the ring buffer into the histograms
+void profile_dump(); // print histograms to the terminal
+int profile_bucket(unsigned int cycles);
+unsigned int profile_bucket_value(int bucket);
+#endif
 	
 
 volatile int pixel_buffer_start; // global variable
 
-int game_tile_positions[9];
-int gameNumber = 0;
+struct game_session session_pool[MAX_SESSIONS];
+struct game_session* session_free_list = NULL;
+struct solver solver_pool[MAX_SOLVERS];
+struct solver* solver_free_list = NULL;
+struct game_session* game = NULL; // the game shown on the VGA, NULL while main() is still starting up
+int move_offset[] = {-TILE_dimension, -1, TILE_dimension, 1}; // up, left, down, right
+
+// keymap consulted by PS2_ISR, entries are swapped around by ACTION_REBIND
+struct key_binding keymap[] = {
+    {PS2_UP_ARROW,   true,  ACTION_SLIDE_UP},
+    {PS2_L_ARROW,    true,  ACTION_SLIDE_LEFT},
+    {PS2_DOWN_ARROW, true,  ACTION_SLIDE_DOWN},
+    {PS2_R_ARROW,    true,  ACTION_SLIDE_RIGHT},
+    {PS2_W,          false, ACTION_SLIDE_UP},
+    {PS2_A,          false, ACTION_SLIDE_LEFT},
+    {PS2_S,          false, ACTION_SLIDE_DOWN},
+    {PS2_D,          false, ACTION_SLIDE_RIGHT},
+    {PS2_E,          false, ACTION_SELECT_NEXT},
+    {PS2_Q,          false, ACTION_SELECT_PREV},
+    {PS2_ENTER,      false, ACTION_MOVE},
+    {PS2_BACKSPACE,  false, ACTION_SHUFFLE},
+    {PS2_H,          false, ACTION_HINT},
+    {PS2_M,          false, ACTION_DEMO},
+    {PS2_U,          false, ACTION_UNDO},
+    {PS2_R,          false, ACTION_REDO},
+    {PS2_HOME,       true,  ACTION_REWIND},
+    {PS2_K,          false, ACTION_REBIND},
+    {PS2_N,          false, ACTION_NEXT_MODE},
+#if PROFILE_ENABLED
+    {PS2_P,          false, ACTION_PROFILE_DUMP},
+#endif
+};
+int keymap_size = sizeof(keymap)/sizeof(keymap[0]);
+int rebind_stage = 0; // 1 waiting for the key to change, 2 for its new key
+int rebind_index;
+
+// mouse state, the cursor is drawn with a save-under so tiles are not redrawn
+unsigned char mouse_bytes[3];
+int mouse_byte_index = 0;
+bool mouse_left_down = false;
+volatile int cursor_x = SCREEN_WIDTH/2;
+volatile int cursor_y = SCREEN_HEIGHT/2;
+volatile bool cursor_visible = false;
+int cursor_saved_x; // where the save-under was taken
+int cursor_saved_y;
+short int cursor_save_under[CURSOR_SIZE][CURSOR_SIZE];
+unsigned char cursor_shape[CURSOR_SIZE] = {0x80, 0xC0, 0xE0, 0xF0, 0xF8, 0xE0, 0xB0, 0x18};
 int value = 0;
-int count=0;
-int no_tile_position = 8;
-int selected_tile_position = 5;
-bool game_over = false;
+int count=0; // seconds played, refreshed by counter()
+
+// game clock state
+volatile unsigned int clock_periods = 0; // timer interrupts since boot
+
+// hint search state
+int hint_board[TILE_dimension*TILE_dimension]; // scratch copy searched by IDA*
+unsigned char distance_table[TILE_dimension*TILE_dimension][TILE_dimension*TILE_dimension]; // [tile][position], row 0 is the no tile
+unsigned long long hint_key; // board_key() of hint_board, updated with every move
+int solution_moves[SOLUTION_MAX_MOVES]; // tile position moved at each step
+int solution_length; // moves in solution_moves, set when the search reaches the goal
+unsigned long long solver_nodes = 0; // states the solvers have visited, cleared by the benchmark
+unsigned long long hint_cache_key[1 << HINT_CACHE_BITS]; // 0 marks an empty slot
+int hint_cache_move[1 << HINT_CACHE_BITS];
+bool hint_ordered = true; // children closest to the goal first, the host tests compare with move order
+
+// game modes, the table is fixed and game_mode_select() loads one entry
+struct game_mode game_modes[GAME_MODES] = {
+    {"timed",      180000,   NO_LIMIT, false, 1},
+    {"untimed",    NO_LIMIT, NO_LIMIT, false, 1},
+    {"move limit", NO_LIMIT, 50,       false, 1}, // HEX5-4 shows the moves left
+    {"countdown",  120000,   NO_LIMIT, true,  1},
+    {"marathon",   600000,   NO_LIMIT, true,  5}, // HEX5-4 shows the boards left
+};
+int mode_index;
+struct game_mode mode;
+int boards_solved = 0; // boards of the current run solved before this one
+
+#if TT_ENABLED
+// transposition table, entries of older iterations are free so it is never cleared
+struct tt_bucket tt_table[1 << TT_BUCKET_BITS];
+unsigned int tt_iteration = 0;
+unsigned int tt_probes = 0;
+unsigned int tt_hits = 0;
+#endif
+
+#if BIBFS_ENABLED
+// bidirectional solver state, [0] searches from the board and [1] from the goal
+struct bibfs_side bibfs_sides[2];
+#endif
+
+#if PDB_ENABLED
+unsigned char pdb_table[(PDB_ENTRIES*PDB_BITS + 7)/8];
+unsigned int pdb_queue[PDB_ENTRIES]; // only used while pdb_init() runs
+unsigned int pdb_goal_rank;
+int hint_pattern[PDB_TILES + 1]; // pdb_pattern() of hint_board, updated with every move
+int hint_pdb; // pattern distance of hint_board
+#endif
+
+#if HINT_TABLE_ENABLED
+// distance to the goal mod 3 of every board, HINT_TABLE_EMPTY for the
+// unsolvable half; filled a slice at a time by hint_table_step()
+unsigned char hint_table[HINT_TABLE_ENTRIES/4];
+unsigned int hint_table_goal; // board_rank() of the goal
+int hint_table_depth; // layer being expanded
+unsigned int hint_table_scan; // next rank to look at in the layer
+int hint_table_added; // boards the layer has added so far
+volatile bool hint_table_ready = false; // read by get_hint() from PS2_ISR
+unsigned long long hint_distance_key = 0; // board of the last hint_table_distance() answer
+int hint_distance;
+#endif
+
+#if LAYER_STATS_ENABLED
+// breadth-first layers of the whole state space, each sorted by key. The
+// neighbours of a board are one layer up or down (see board_neighbour()), so
+// only the previous layer is needed to drop boards that were already counted
+unsigned long long layer_states[2][LAYER_MAX_STATES];
+unsigned long long layer_candidates[4*LAYER_MAX_STATES]; // children of the current layer
+int layer_previous; // index into layer_states, the current layer is the other one
+int layer_size[2];
+int layer_depth;
+unsigned int layer_total;
+unsigned int layer_elapsed_ms;
+bool layer_done = true;
+#endif
+
+// built in corpus, the board literal reads row by row with 0 for the no tile
+const struct {
+    struct corpus_header header;
+    struct corpus_record records[11];
+} builtin_corpus = {
+    {CORPUS_MAGIC, TILE_dimension, CORPUS_BUCKETS, 0, 11, {0, 1, 7, 11, 11}},
+    {
+        {0x123450786ULL, 1,  0},
+        {0x013475826ULL, 10, 1},
+        {0x012483576ULL, 10, 1},
+        {0x273016548ULL, 11, 1},
+        {0x430521786ULL, 12, 1},
+        {0x235106487ULL, 12, 1},
+        {0x136805472ULL, 14, 1},
+        {0x260483715ULL, 16, 2},
+        {0x340158726ULL, 18, 2},
+        {0x402567813ULL, 21, 2},
+        {0x238065714ULL, 21, 2},
+    }
+};
+const struct corpus_header* corpus = NULL;
+const struct corpus_record* corpus_records;
+int corpus_count = 0; // 0 if no corpus is open, shuffle() falls back to random boards
+
+// leaderboard state
+struct score_store* score_store = (struct score_store*) SCORE_STORE_BASE; // host tests point it elsewhere
+struct score_record* score_log; // the active log of score_store
+int score_log_length = 0; // records committed to the log
+int leaderboard_index[LEADERBOARD_BOARDS][LEADERBOARD_TOP]; // log records, best first
+int leaderboard_count[LEADERBOARD_BOARDS];
+
+// demo state, the moves are played from the main loop, never from an ISR
+bool demo_mode = false;
+volatile bool demo_toggle_requested = false; // set by PS2_ISR, handled in counter()
+volatile unsigned int last_input_ms = 0;
+struct solver* demo_solver; // path of the board the demo is playing
+struct solver* hint_solver; // path get_hint() follows until the hint table is ready
+unsigned int demo_next_move_ms = 0;
 
 int win[];
 int lose[];
 
+#if PROFILE_ENABLED
+// ring buffer of raw samples, filled from IRQ context and drained in counter()
+unsigned int profile_ring[PROFILE_RING_SIZE];
+volatile unsigned int profile_head = 0;
+volatile unsigned int profile_tail = 0;
+volatile unsigned int profile_dropped = 0;
+volatile bool profile_dump_requested = false;
+// latency histograms, one per probe
+unsigned int profile_histogram[PROF_NUM_PROBES][PROFILE_BUCKETS];
+unsigned int profile_max[PROF_NUM_PROBES];
+#endif
+
 
 int main(){
     
-    config_all_IRQ_interrupts();
-
     volatile int * pixel_ctrl_ptr = (int *)0xFF203020;
-    /* Read location of the pixel buffer from the pixel buffer controller */
+    /* Read location of the pixel buffer from the pixel buffer controller,
+       before any ISR can draw */
     pixel_buffer_start = *pixel_ctrl_ptr;
+
+    config_all_IRQ_interrupts();
+
 	clear_screen();
+	session_pool_init();
+	solver_pool_init();
+	demo_solver = solver_create();
+	hint_solver = solver_create();
+	distance_table_init();
+#if HINT_TABLE_ENABLED
+	hint_table_init();
+#endif
+#if PDB_ENABLED
+	pdb_init();
+#endif
+#if LAYER_STATS_ENABLED
+	layer_stats_start();
+#endif
+	corpus_open(&builtin_corpus.header);
+	leaderboard_load();
+#if BENCHMARK_ENABLED
+	solver_benchmark();
+#endif
+	game_mode_select(GAME_MODE_DEFAULT);
+	game = session_alloc();
 	draw_initial_game_tiles();
+	cursor_show();
 	
     while(1)
 	counter();
@@ -117,6 +746,10 @@ void config_all_IRQ_interrupts(){
     config_GIC();
 	config_interval_timer();
     config_PS2();
+    config_mouse();
+#if PROFILE_ENABLED
+    config_private_timer();
+#endif
     enable_A9_interrupts();
 }
 
@@ -125,8 +758,8 @@ void config_interval_timer()
 {
 	volatile int * interval_timer_ptr =
 	(int *)TIMER_BASE; // interal timer base address
-	/* set the interval timer period for scrolling the HEX displays */
-	int counter = 100000000; // 1/(100 MHz) x 5x10^6 = 50 msec
+	/* set the interval timer period for the game clock */
+	int counter = TIMER_PERIOD - 1; // counts down to 0 inclusive, 1 sec at 100 MHz
 	*(interval_timer_ptr + 0x2) = (counter & 0xFFFF);
 	*(interval_timer_ptr + 0x3) = (counter >> 16) & 0xFFFF;
 	/* start interval timer, enable its interrupts */
@@ -162,6 +795,7 @@ void config_GIC(){
     int address;
 
     config_interrupts(PS2_IRQ, 1);
+    config_interrupts(PS2_DUAL_IRQ, 1);
 
     *((int *)0xFFFED8C4) = 0x01000000;
 	*((int *)0xFFFED118) = 0x00000080;
@@ -192,6 +826,8 @@ void __attribute__((interrupt)) __cs3_isr_irq(void)
 		interval_timer_ISR();
 	else if (interrupt_ID == 79)
        PS2_ISR();
+	else if (interrupt_ID == PS2_DUAL_IRQ)
+       mouse_ISR();
 	else
 	while (1); // if unexpected, then stay here
 	// Write to the End of Interrupt Register (ICCEOIR)
@@ -230,263 +866,1991 @@ void __attribute__((interrupt)) __cs3_isr_fiq(void)
 
 void interval_timer_ISR()
 {
+	PROFILE_BEGIN();
 	volatile int * interval_timer_ptr = (int *)TIMER_BASE;	
 	*(interval_timer_ptr) = 0; // Clear the interrupt
-	if (!game_over){
-        count++;
-    }
+	// always count, pausing is handled by the game clock
+	clock_periods++;
+	// the counter has just reloaded, so the period count is the system time;
+	// a game runs out of time on the first tick at or after its deadline
+	if (game != NULL){
+		session_check_deadline(game, clock_periods*TIMER_MS_PER_PERIOD);
+	}
+	PROFILE_END(PROF_TIMER_ISR);
 	return;
 }
 
 
 // ISR for keyboard
 void PS2_ISR(){
+    PROFILE_BEGIN();
     volatile int* PS2_ptr = (int *) PS2_BASE;
 
     int PS2_data = *(PS2_ptr) & 0xFF;
     if (PS2_data == 0xF0) {
         display_on_hex(16,16,16,16,16,16);
-        PS2_data = *(PS2_ptr) & 0xFF;
-        if (PS2_data == PS2_ENTER)
-        {
-            swap_tile();
-        } 
-        else if (PS2_data == PS2_BACKSPACE)
-        {
-            shuffle();
-        } 
+        key_released(*(PS2_ptr) & 0xFF, false);
     } else if (PS2_data == 0xE0) {
         display_on_hex(16,16,16,16,16,16);
         PS2_data = *(PS2_ptr) & 0xFF;
         if (PS2_data == 0xF0){
-            PS2_data = *(PS2_ptr) & 0xFF;
-            if (PS2_data == PS2_R_ARROW)
-            {
-                select_new_selected_tile(-1);
-            } 
-            else if (PS2_data == PS2_L_ARROW)
-            {
-                select_new_selected_tile(1);
-            }
+            key_released(*(PS2_ptr) & 0xFF, true);
         }
     }	
 
+    PROFILE_END(PROF_PS2_ISR);
     return;
 }
 
 
 void shuffle()
 {
-    if (game_over){
-        game_over = false;
+    if (game->game_over){
+        game->game_over = false;
 		
         clear_screen();
-		count = 0;
-    }
-	count = 0;
-
-    int game0[] = {2,7,3,NO_TILE,1,6,5,4,8};
-    int game1[] = {4,NO_TILE,2,5,6,7,8,1,3};
-    int game2[] = {3,4,NO_TILE,1,5,8,7,2,6};
-    int game3[] = {1,2,3,4,5,NO_TILE,7,8,6};
-	int game4[] = {4,3,NO_TILE,5,2,1,7,8,6};
-	int game5[] = {2,3,5,1,NO_TILE,6,4,8,7};
-	int game6[] = {2,6,NO_TILE,4,8,3,7,1,5};
-	int game7[] = {1,3,6,8,NO_TILE,5,4,7,2};
-	int game8[] = {NO_TILE,1,3,4,7,5,8,2,6};
-	int game9[] = {NO_TILE,1,2,4,8,3,5,7,6};
-	int game10[] ={2,3,8,NO_TILE,6,5,7,1,4};
+    }
+	game = session_recycle(game);
+	game_clock_reset(game);
+	boards_solved = 0;
+
+	int status = BOARD_MALFORMED;
 	value = 0;
-	if(gameNumber==0)
-	{
-		new_game_board(game_tile_positions,game0);
-	}
-  	 else if(gameNumber==1)
-	{
-		new_game_board(game_tile_positions,game1);
-	}
-	 else if(gameNumber==2)
-	{
-		new_game_board(game_tile_positions,game2);
-	}
-     else if(gameNumber==3)
-	{
-		new_game_board(game_tile_positions,game3);
-	}
-	 else if(gameNumber==4)
-	{
-		new_game_board(game_tile_positions,game4);
-	}
-	 else if(gameNumber==5)
-	{
-		new_game_board(game_tile_positions,game5);
-	}
-	 else if(gameNumber==6)
-	{
-		new_game_board(game_tile_positions,game6);
-	}
-	 else if(gameNumber==7)
-	{
-		new_game_board(game_tile_positions,game7);
-	}
-	 else if(gameNumber==8)
+	game->board_number = game->game_number;
+	if (game->game_number < corpus_count)
 	{
-		new_game_board(game_tile_positions,game8);
+		int board[TILE_dimension*TILE_dimension];
+		corpus_board(game->game_number, board);
+		status = new_game_board(game, board);
 	}
-	 else if(gameNumber==9)
-	{
-		new_game_board(game_tile_positions,game9);
+    if (status != BOARD_VALID){
+        printf("board %d is %s\n", game->board_number,
+               status == BOARD_UNSOLVABLE ? "unsolvable, two tiles swapped" : "malformed, random board instead");
+    }
+    if (status == BOARD_MALFORMED){
+        int board[TILE_dimension*TILE_dimension];
+        random_board(board);
+        new_game_board(game, board);
+        game->board_number = NO_BOARD; // not the board the leaderboard knows by that number
+    }
+    if (game->game_number + 1 >= corpus_count){
+        game->game_number = 0;
+    } else {
+        ++game->game_number;
+    }
+  	
+    for (int k = 0; k < 9; ++k){
+       draw_tile(k);
+    }
+
+    reset_selected_tile();
+
+}
+
+
+void session_pool_init(){
+    session_free_list = NULL;
+    for (int i = MAX_SESSIONS - 1; i >= 0; --i){
+        session_pool[i].next_free = session_free_list;
+        session_free_list = &session_pool[i];
+    }
+}
+
+
+struct game_session* session_alloc(){
+    struct game_session* s = session_free_list;
+    if (s == NULL){
+        return NULL;
+    }
+    session_free_list = s->next_free;
+    memset(s, 0, sizeof(struct game_session));
+    return s;
+}
+
+
+void session_free(struct game_session* s){
+    s->next_free = session_free_list;
+    session_free_list = s;
+}
+
+
+// called where a game ends and the next one starts; the free list is LIFO so
+// the new game reuses the same slot, only the board number carries over
+struct game_session* session_recycle(struct game_session* s){
+    int game_number = s->game_number;
+    session_free(s);
+    s = session_alloc();
+    s->game_number = game_number;
+    return s;
+}
+
+
+// an unsolvable board is repaired in the session, the caller's array is left alone
+int new_game_board(struct game_session* s, int board[])
+{
+	int status = board_validate(board);
+	if (status == BOARD_MALFORMED){
+		return status;
 	}
-	else if(gameNumber==10)
-	{
-		new_game_board(game_tile_positions,game9);
+	for(int i=0;i<TILE_dimension*TILE_dimension;i++)
+		{
+			s->game_tile_positions[i]=board[i];
+		}
+	if (status == BOARD_UNSOLVABLE){
+		board_repair(s->game_tile_positions);
 	}
-    // generate an automatic winning board for demo
-    if (gameNumber == 10){
-        new_game_board(game_tile_positions, game3);
-        gameNumber = 0;
-    } else {
-        ++gameNumber;
+	for(int i=0;i<TILE_dimension*TILE_dimension;i++)
+		{
+            if (s->game_tile_positions[i] == NO_TILE){
+                s->no_tile_position = i;
+            }
+			s->checkpoints[0][i] = s->game_tile_positions[i];
+		}
+	board_stats_recompute(s);
+	s->history_length = 0;
+	s->history_position = 0;
+	return status;
+}
+
+
+// swap tile at selected position with no tile position, ends the game once solved
+bool session_move(struct game_session* s){
+    if (s->game_over){
+        return false;
+    }
+
+    int step = slide_step(s);
+    if (step == 0){
+        return false;
+    }
+    // every tile between the no tile and the selected one moves one place,
+    // recorded as single tile moves so restore stays simple; the last one is
+    // marked so undo and redo take the whole slide, the unit moves counts
+    int target = s->selected_tile_position;
+    while (s->no_tile_position != target){
+        int to = s->no_tile_position;
+        session_apply(s, to + step);
+        history_record(s, to + step, to);
+    }
+    if (s->history_position > 0){
+        int last = s->history_position - 1;
+        s->history_ends[last/8] |= 1 << last%8;
+    }
+    s->moves++;
+
+    if (s->misplaced_tiles == 0){
+        game_clock_pause(s);
+        s->game_over = true;
+    } else if (mode.move_limit != NO_LIMIT && s->moves >= mode.move_limit){
+        s->limit_reached = true;
+    }
+    return true;
+}
+
+
+// direction_offset = -1 for left, +1 for right
+void session_select(struct game_session* s, int direction_offset){
+    int selectable_tiles[SELECTABLE_MAX]; // array of selectable tile position
+    int selectable_tiles_num; // number of tiles selectable
+    int current_select_index = 0; // index of currently selected tile wrt selectable_tiles array
+
+    get_selectable_tiles(s, selectable_tiles, &selectable_tiles_num, &current_select_index);
+    int select_index = current_select_index + direction_offset;
+
+    if (select_index < 0) {
+        select_index = selectable_tiles_num-1;
+    } if (select_index >= selectable_tiles_num) {
+        select_index = 0;
+    }
+    s->selected_tile_position = selectable_tiles[select_index];
+}
+
+
+void session_reset_selection(struct game_session* s){
+    int selectable_tiles[SELECTABLE_MAX];
+    int temp1, temp2;
+    get_selectable_tiles(s, selectable_tiles, &temp1, &temp2);
+    s->selected_tile_position = selectable_tiles[0];
+}
+
+
+// a solved board is over before its last move counts against the limit,
+// even if the timer ISR ran out the clock in between
+bool session_limit_reached(struct game_session* s){
+    return s->limit_reached && !s->game_over;
+}
+
+
+void session_check_deadline(struct game_session* s, unsigned int now_ms){
+    if (!s->game_over && mode.time_limit_ms != NO_LIMIT && (int)(now_ms - s->deadline_ms) >= 0){
+        s->limit_reached = true;
+    }
+}
+
+
+int slide_step(struct game_session* s){
+    int selected = s->selected_tile_position;
+    int no_tile = s->no_tile_position;
+    if (selected == no_tile){
+        return 0;
+    }
+    if (selected / TILE_dimension == no_tile / TILE_dimension){
+        return selected > no_tile ? 1 : -1;
+    }
+    if (selected % TILE_dimension == no_tile % TILE_dimension){
+        return selected > no_tile ? TILE_dimension : -TILE_dimension;
+    }
+    return 0;
+}
+
+
+// the tile moving up is the one below the no tile, so step back against the offset
+// the tile sliding in direction is on the opposite side of the no tile
+int session_neighbour(struct game_session* s, int direction){
+    return board_neighbour(s->no_tile_position, (direction + 2) % 4);
+}
+
+
+void session_apply(struct game_session* s, int position){
+    int to = s->no_tile_position;
+    s->game_tile_positions[to] = s->game_tile_positions[position];
+    s->game_tile_positions[position] = NO_TILE;
+
+    // the selection follows the tile, the no tile takes its old place
+    s->no_tile_position = position;
+    s->selected_tile_position = to;
+    board_stats_update(s, position, to);
+}
+
+
+// a new move drops whatever could have been redone
+void history_record(struct game_session* s, int from, int to){
+    // full: start over with the current board as the first checkpoint
+    if (s->history_position == HISTORY_MAX_MOVES){
+        for (int i = 0; i < TILE_dimension*TILE_dimension; ++i){
+            s->checkpoints[0][i] = s->game_tile_positions[i];
+        }
+        s->history_position = 0;
+        s->history_length = 0;
+        return;
+    }
+
+    int index = s->history_position;
+    int direction = 0;
+    while (move_offset[direction] != from - to){
+        direction++;
+    }
+    s->history[index/4] &= ~(0x3 << (index%4)*2);
+    s->history[index/4] |= direction << (index%4)*2;
+    s->history_ends[index/8] &= ~(1 << index%8);
+    s->history_position++;
+    s->history_length = s->history_position;
+
+    if (s->history_position % HISTORY_CHECKPOINT == 0 && s->history_position < HISTORY_MAX_MOVES){
+        for (int i = 0; i < TILE_dimension*TILE_dimension; ++i){
+            s->checkpoints[s->history_position/HISTORY_CHECKPOINT][i] = s->game_tile_positions[i];
+        }
+    }
+}
+
+
+int history_direction(struct game_session* s, int index){
+    return (s->history[index/4] >> (index%4)*2) & 0x3;
+}
+
+
+bool history_slide_end(struct game_session* s, int index){
+    return (s->history_ends[index/8] >> index%8) & 1;
+}
+
+
+// the slide to take back ends where the no tile was before it, selecting
+// that tile slides the whole run back
+int history_undo_tile(struct game_session* s){
+    if (s->game_over || s->history_position == 0){
+        return NO_TILE;
+    }
+    int position = s->no_tile_position;
+    int index = s->history_position;
+    do {
+        index--;
+        position -= move_offset[history_direction(s, index)];
+    } while (index > 0 && !history_slide_end(s, index - 1));
+    return position;
+}
+
+
+int history_redo_tile(struct game_session* s){
+    if (s->game_over || s->history_position == s->history_length){
+        return NO_TILE;
+    }
+    int position = s->no_tile_position;
+    int index = s->history_position;
+    do {
+        position += move_offset[history_direction(s, index)];
+        index++;
+    } while (index < s->history_length && !history_slide_end(s, index - 1));
+    return position;
+}
+
+
+bool session_undo(struct game_session* s){
+    if (history_undo_tile(s) == NO_TILE){
+        return false;
+    }
+    do {
+        s->history_position--;
+        session_apply(s, s->no_tile_position - move_offset[history_direction(s, s->history_position)]);
+    } while (s->history_position > 0 && !history_slide_end(s, s->history_position - 1));
+    return true;
+}
+
+
+bool session_redo(struct game_session* s){
+    if (history_redo_tile(s) == NO_TILE){
+        return false;
+    }
+    do {
+        session_apply(s, s->no_tile_position + move_offset[history_direction(s, s->history_position)]);
+        s->history_position++;
+    } while (s->history_position < s->history_length && !history_slide_end(s, s->history_position - 1));
+    if (s->misplaced_tiles == 0){
+        game_clock_pause(s);
+        s->game_over = true;
+    }
+    return true;
+}
+
+
+// loads the closest checkpoint at or before position and replays at most
+// HISTORY_CHECKPOINT - 1 moves, so the cost does not grow with the history
+void session_restore(struct game_session* s, int position){
+    if (s->game_over || position < 0 || position > s->history_length){
+        return;
+    }
+    int checkpoint = position/HISTORY_CHECKPOINT;
+    if (checkpoint == HISTORY_CHECKPOINTS){
+        checkpoint--; // a full history has no checkpoint after its last move
+    }
+    for (int i = 0; i < TILE_dimension*TILE_dimension; ++i){
+        s->game_tile_positions[i] = s->checkpoints[checkpoint][i];
+        if (s->game_tile_positions[i] == NO_TILE){
+            s->no_tile_position = i;
+        }
+    }
+    board_stats_recompute(s);
+
+    for (int index = checkpoint*HISTORY_CHECKPOINT; index < position; ++index){
+        session_apply(s, s->no_tile_position + move_offset[history_direction(s, index)]);
+    }
+    s->history_position = position;
+    session_reset_selection(s);
+}
+
+
+void slide_tile(int direction){
+    int position = session_neighbour(game, direction);
+    if (position != NO_TILE){
+        move_tile_at(position);
+    }
+}
+
+
+void move_tile_at(int position){
+    if (game->game_over){
+        return;
+    }
+    draw_selected_tile_frame(true);
+    game->selected_tile_position = position;
+    swap_tile();
+}
+
+
+// swap tile at selected position with no tile position
+void swap_tile(){
+    if (game->game_over){
+        return;
+    }
+    PROFILE_BEGIN();
+
+    // animate tile swapping
+    animate_swap_tile();
+
+    session_move(game);
+    draw_selected_tile_frame(false);
+	check_game_status();
+    PROFILE_END(PROF_SWAP_TILE);
+}
+
+
+// same as swap_tile, the tile slides back the way it came
+void undo_tile(){
+    int position = history_undo_tile(game);
+    if (position == NO_TILE){
+        return;
+    }
+    draw_selected_tile_frame(true);
+    game->selected_tile_position = position;
+    animate_swap_tile();
+    session_undo(game);
+    draw_selected_tile_frame(false);
+}
+
+
+void redo_tile(){
+    int position = history_redo_tile(game);
+    if (position == NO_TILE){
+        return;
+    }
+    draw_selected_tile_frame(true);
+    game->selected_tile_position = position;
+    animate_swap_tile();
+    session_redo(game);
+    draw_selected_tile_frame(false);
+	check_game_status();
+}
+
+
+void rewind_board(){
+    if (game->game_over){
+        return;
+    }
+    session_restore(game, 0);
+    for (int k = 0; k < TILE_dimension*TILE_dimension; ++k){
+       draw_tile(k);
+    }
+    draw_selected_tile_frame(false);
+}
+
+
+// reset selected tile and redraw the frame
+void reset_selected_tile(){
+    // set new selected tile
+    session_reset_selection(game);
+    // draw frame
+    draw_selected_tile_frame(false);
+}
+
+
+// animate the motion of tile moving from selected tile position -> no tile position
+void animate_swap_tile(){
+    volatile int * pixel_ctrl_ptr = (int *)0xFF203020;
+
+    int row_selected = game->selected_tile_position % 3;
+    int col_selected = game->selected_tile_position / 3;
+    int row_no_tile = game->no_tile_position % 3;
+    int col_no_tile = game->no_tile_position / 3;
+
+    // determine how much to move by
+    int anim_x = 0;
+    int anim_y = 0;
+    if (row_no_tile == row_selected){
+        if (col_no_tile > col_selected){
+            anim_y = 15;
+        } else if (col_no_tile < col_selected){
+            anim_y = -15;
+        }
+    } else if (col_no_tile == col_selected){
+        if (row_no_tile > row_selected){
+            anim_x = 20;
+        } else if (row_no_tile < row_selected){
+            anim_x = -20;
+        }
+    }
+
+    // the run of tiles from the selected tile up to the no tile all slide together
+    int run[TILE_dimension - 1];
+    int run_length = 0;
+    int step = -slide_step(game);
+    for (int p = game->selected_tile_position; p != game->no_tile_position; p += step){
+        run[run_length++] = p;
+    }
+
+    // erase the run
+    int offset_x = 0;
+    int offset_y = 0;
+    for (int k = 0; k < run_length; ++k){
+        int x = 12 + (run[k] % 3)*100;
+        int y = 12 + (run[k] / 3)*75;
+        drawing_png(x, y, get_png_of_tile(NO_TILE), x);
+    }
+    offset_x += anim_x;
+    offset_y += anim_y;
+
+    while(1){
+        PROFILE_BEGIN();
+        // draw
+        for (int k = 0; k < run_length; ++k){
+            int x = 12 + (run[k] % 3)*100 + offset_x;
+            int y = 12 + (run[k] / 3)*75 + offset_y;
+            drawing_png(x, y, get_png_of_tile(game->game_tile_positions[run[k]]), x);
+        }
+
+        // every tile has moved one place, the last frame is only drawn
+        if ((anim_x != 0 && abs(offset_x) == 100) || (anim_y != 0 && abs(offset_y) == 75)){
+            PROFILE_END(PROF_FRAME);
+            break;
+        }
+
+        wait_for_vsync();        
+        pixel_buffer_start = *(pixel_ctrl_ptr + 1); // new back buffer
+
+        // erase
+        for (int k = 0; k < run_length; ++k){
+            int x = 12 + (run[k] % 3)*100 + offset_x;
+            int y = 12 + (run[k] / 3)*75 + offset_y;
+            drawing_png(x, y, get_png_of_tile(NO_TILE), x);
+        }
+        // move
+        offset_x += anim_x;
+        offset_y += anim_y;
+        PROFILE_END(PROF_FRAME);
+    }
+}
+
+
+void check_game_status()
+{
+	// the demo keeps playing new boards instead of showing the win page
+	if(game->game_over && !demo_mode)
+	{
+		printf("solved in %d moves, %d keys\n", game->moves, game->keystrokes);
+		// the next board of a run keeps the clock going
+		if (boards_solved + 1 < mode.boards){
+			int solved = boards_solved + 1;
+			unsigned int start_ms = game->start_ms;
+			unsigned int deadline_ms = game->deadline_ms;
+			shuffle();
+			boards_solved = solved;
+			game->start_ms = start_ms;
+			game->deadline_ms = deadline_ms;
+			return;
+		}
+		// only single board games are comparable per board
+		if (mode.boards == 1 && game->board_number != NO_BOARD){
+			volatile int* SW_ptr = (int*) SW_BASE;
+			leaderboard_append(game->board_number, game->moves, game_clock_ms(game), *(SW_ptr) & 0x3FF);
+			leaderboard_print(game->board_number);
+		}
+		clear_screen();
+		drawing_png2(80,40,win,80);
+	}
+	
+}
+
+
+void game_mode_select(int index){
+    mode_index = index;
+    mode = game_modes[index];
+    printf("mode: %s\n", mode.name);
+}
+
+
+void next_game_mode(){
+    game_mode_select((mode_index + 1) % GAME_MODES);
+    game->game_over = true; // shuffle() clears the win/lose page
+    shuffle();
+}
+
+
+int tile_distance(int tile, int position){
+    int goal = tile - 1;
+    return abs(goal % TILE_dimension - position % TILE_dimension) +
+           abs(goal / TILE_dimension - position / TILE_dimension);
+}
+
+
+void distance_table_init(){
+    for (int position = 0; position < TILE_dimension*TILE_dimension; ++position){
+        distance_table[0][position] = 0;
+        for (int tile = 1; tile < TILE_dimension*TILE_dimension; ++tile){
+            distance_table[tile][position] = tile_distance(tile, position);
+        }
+    }
+}
+
+
+// number of tiles in their goal line that must leave it to put the line in order
+// (line length minus longest increasing run of goal positions), so 2 moves each
+int line_conflicts(struct game_session* s, int line, bool is_row){
+    int goals[TILE_dimension];
+    int longest[TILE_dimension];
+    int size = 0;
+    int best = 0;
+
+    for (int k = 0; k < TILE_dimension; ++k){
+        int position = is_row ? line*TILE_dimension + k : k*TILE_dimension + line;
+        int tile = s->game_tile_positions[position];
+        if (tile == NO_TILE){
+            continue;
+        }
+        int goal_line = is_row ? (tile - 1) / TILE_dimension : (tile - 1) % TILE_dimension;
+        if (goal_line == line){
+            goals[size++] = tile;
+        }
+    }
+    for (int i = 0; i < size; ++i){
+        longest[i] = 1;
+        for (int j = 0; j < i; ++j){
+            if (goals[j] < goals[i] && longest[j] + 1 > longest[i]){
+                longest[i] = longest[j] + 1;
+            }
+        }
+        if (longest[i] > best){
+            best = longest[i];
+        }
+    }
+    return size - best;
+}
+
+
+void board_stats_recompute(struct game_session* s){
+    s->misplaced_tiles = 0;
+    s->manhattan_distance = 0;
+    s->linear_conflicts = 0;
+    s->inversions = 0;
+
+    for (int i = 0; i < TILE_dimension*TILE_dimension; ++i){
+        int tile = s->game_tile_positions[i];
+        if (tile == NO_TILE){
+            continue;
+        }
+        if (tile != i + 1){
+            s->misplaced_tiles++;
+        }
+        s->manhattan_distance += tile_distance(tile, i);
+    }
+    s->inversions = board_inversions(s->game_tile_positions);
+    for (int line = 0; line < TILE_dimension; ++line){
+        s->row_conflicts[line] = line_conflicts(s, line, true);
+        s->col_conflicts[line] = line_conflicts(s, line, false);
+        s->linear_conflicts += s->row_conflicts[line] + s->col_conflicts[line];
+    }
+}
+
+
+// called after the board changed: the tile now at `to` used to be at `from`
+void board_stats_update(struct game_session* s, int from, int to){
+    int tile = s->game_tile_positions[to];
+
+    s->misplaced_tiles += (tile != to + 1) - (tile != from + 1);
+    s->manhattan_distance += tile_distance(tile, to) - tile_distance(tile, from);
+
+    // a vertical move jumps over the tiles in between, flipping those pairs;
+    // a horizontal move has nothing in between
+    int low = from < to ? from : to;
+    int high = from < to ? to : from;
+    for (int i = low + 1; i < high; ++i){
+        bool was_inverted = (from < to) == (tile > s->game_tile_positions[i]);
+        s->inversions += was_inverted ? -1 : 1;
+    }
+
+    // only the lines the tile left and entered can change order
+    int lines[] = {from / TILE_dimension, to / TILE_dimension};
+    bool is_row = true;
+    if (from % TILE_dimension != to % TILE_dimension){
+        lines[0] = from % TILE_dimension;
+        lines[1] = to % TILE_dimension;
+        is_row = false;
+    }
+    for (int k = 0; k < 2; ++k){
+        int* conflicts = is_row ? &s->row_conflicts[lines[k]] : &s->col_conflicts[lines[k]];
+        s->linear_conflicts -= *conflicts;
+        *conflicts = line_conflicts(s, lines[k], is_row);
+        s->linear_conflicts += *conflicts;
+    }
+
+#if BOARD_STATS_CHECK
+    int check[] = {s->misplaced_tiles, s->manhattan_distance, s->linear_conflicts, s->inversions};
+    board_stats_recompute(s);
+    if (check[0] != s->misplaced_tiles || check[1] != s->manhattan_distance ||
+        check[2] != s->linear_conflicts || check[3] != s->inversions){
+        printf("board stats mismatch: %d/%d %d/%d %d/%d %d/%d\n",
+               check[0], s->misplaced_tiles, check[1], s->manhattan_distance,
+               check[2], s->linear_conflicts, check[3], s->inversions);
+    }
+#endif
+}
+
+
+int board_distance(struct game_session* s){
+    return s->manhattan_distance + 2*s->linear_conflicts;
+}
+
+
+// odd widths need an even number of inversions, even widths need the
+// inversions plus the no tile row counted from the bottom to be odd
+bool board_is_solvable(struct game_session* s){
+    return board_parity_solvable(s->inversions, s->no_tile_position);
+}
+
+
+bool board_parity_solvable(int inversions, int no_tile_position){
+    if (TILE_dimension % 2 == 1){
+        return inversions % 2 == 0;
+    }
+    return (inversions + TILE_dimension - no_tile_position / TILE_dimension) % 2 == 1;
+}
+
+
+// walks the board from the end, the tree counts the smaller tiles already seen
+int board_inversions(int board[]){
+    int tree[TILE_dimension*TILE_dimension] = {0}; // 1 based over tiles 1..n-1
+    int inversions = 0;
+    for (int i = TILE_dimension*TILE_dimension - 1; i >= 0; --i){
+        int tile = board[i];
+        if (tile <= 0){
+            continue; // the no tile, or a malformed board that must not hang the tree walk
+        }
+        for (int k = tile - 1; k > 0; k -= k & -k){
+            inversions += tree[k];
+        }
+        for (int k = tile; k < TILE_dimension*TILE_dimension; k += k & -k){
+            tree[k]++;
+        }
+    }
+    return inversions;
+}
+
+
+int board_validate(int board[]){
+    bool seen[TILE_dimension*TILE_dimension] = {false}; // seen[0] is the no tile
+    int no_tile_position = 0;
+    for (int i = 0; i < TILE_dimension*TILE_dimension; ++i){
+        // only NO_TILE is the blank, a 0 is the usual slip in a hand written board
+        if (board[i] == 0){
+            return BOARD_MALFORMED;
+        }
+        int tile = board[i] == NO_TILE ? 0 : board[i];
+        if (tile < 0 || tile >= TILE_dimension*TILE_dimension || seen[tile]){
+            return BOARD_MALFORMED;
+        }
+        seen[tile] = true;
+        if (tile == 0){
+            no_tile_position = i;
+        }
+    }
+    if (!board_parity_solvable(board_inversions(board), no_tile_position)){
+        return BOARD_UNSOLVABLE;
+    }
+    return BOARD_VALID;
+}
+
+
+// the first two tiles, skipping the no tile so it stays in place
+void board_repair(int board[]){
+    int first = board[0] == NO_TILE ? 1 : 0;
+    int second = board[first + 1] == NO_TILE ? first + 2 : first + 1;
+    int temp = board[first];
+    board[first] = board[second];
+    board[second] = temp;
+}
+
+
+int boards_validate(int boards[], int count){
+    int valid = 0;
+    for (int i = 0; i < count; ++i){
+        if (board_validate(&boards[i*TILE_dimension*TILE_dimension]) == BOARD_VALID){
+            ++valid;
+        }
+    }
+    return valid;
+}
+
+
+unsigned long long board_key(int board[]){
+    unsigned long long key = 0;
+    for (int i = 0; i < TILE_dimension*TILE_dimension; ++i){
+        int tile = board[i] == NO_TILE ? 0 : board[i];
+        key = (key << 4) | tile;
+    }
+    return key;
+}
+
+
+// Fibonacci hashing, the top bits of the product mix every nibble of the key
+int key_hash(unsigned long long key, int bits){
+    return (int)((key * 0x9E3779B97F4A7C15ULL) >> (64 - bits));
+}
+
+
+// every move changes the no tile's colour on a chessboard, so the graph of
+// boards is bipartite: the neighbours of a board d moves from the goal are
+// d-1 or d+1 moves from it, never d. The breadth-first searches and the
+// mod 3 tables rely on this
+int board_neighbour(int blank, int direction){
+    int position = blank + move_offset[direction];
+    if (position < 0 || position >= TILE_dimension*TILE_dimension){
+        return NO_TILE;
+    }
+    // left and right must stay in the same row
+    if (direction % 2 == 1 && position / TILE_dimension != blank / TILE_dimension){
+        return NO_TILE;
+    }
+    return position;
+}
+
+
+// Lehmer code read as a mixed radix number, digit i counts the values not
+// used yet that are smaller than values[i] and has radix n-i. The used values
+// are a bit mask so a digit is one popcount instead of a loop over values[0..i-1]
+unsigned long long permutation_rank(const int values[], int k){
+    unsigned int used = 0;
+    unsigned long long rank = 0;
+    for (int i = 0; i < k; ++i){
+        int value = values[i];
+        int digit = value - __builtin_popcount(used & ((1u << value) - 1));
+        rank = rank*(TILE_dimension*TILE_dimension - i) + digit;
+        used |= 1u << value;
+    }
+    return rank;
+}
+
+
+void permutation_unrank(unsigned long long rank, int values[], int k){
+    int digits[TILE_dimension*TILE_dimension];
+    for (int i = k - 1; i >= 0; --i){
+        int radix = TILE_dimension*TILE_dimension - i;
+        digits[i] = rank % radix;
+        rank /= radix;
+    }
+    // value i is the digit'th lowest value still unused
+    unsigned int unused = (1u << (TILE_dimension*TILE_dimension)) - 1;
+    for (int i = 0; i < k; ++i){
+        unsigned int candidates = unused;
+        for (int d = 0; d < digits[i]; ++d){
+            candidates &= candidates - 1;
+        }
+        values[i] = __builtin_ctz(candidates);
+        unused &= ~(1u << values[i]);
+    }
+}
+
+
+unsigned long long board_rank(int board[]){
+    int values[TILE_dimension*TILE_dimension];
+    for (int i = 0; i < TILE_dimension*TILE_dimension; ++i){
+        values[i] = board[i] == NO_TILE ? 0 : board[i];
+    }
+    return permutation_rank(values, TILE_dimension*TILE_dimension);
+}
+
+
+void board_unrank(unsigned long long rank, int board[]){
+    permutation_unrank(rank, board, TILE_dimension*TILE_dimension);
+    for (int i = 0; i < TILE_dimension*TILE_dimension; ++i){
+        if (board[i] == 0){
+            board[i] = NO_TILE;
+        }
+    }
+}
+
+
+// returns HINT_FOUND if the goal is reachable within bound, otherwise the
+// smallest f value that went over the bound, to be used as the next bound.
+// f is in tenths of a move so h can be weighted by SOLVER_WEIGHT; above 10 h
+// overestimates, whole subtrees are cut and the first solution found can be longer
+int hint_search(int blank, int prev_blank, int g, int bound, int h){
+    solver_nodes++;
+    int estimate = h;
+#if PDB_ENABLED
+    if (hint_pdb > estimate){
+        estimate = hint_pdb;
+    }
+#endif
+    int f = 10*g + SOLVER_WEIGHT*estimate;
+    if (f > bound){
+        return f;
+    }
+    if (h == 0){
+        solution_length = g;
+        return HINT_FOUND;
+    }
+    if (g == SOLUTION_MAX_MOVES){
+        return HINT_NOT_FOUND;
+    }
+#if TT_ENABLED
+    // the earlier visit searched the same subtree with more moves to spare,
+    // so it already found the solution or reported a lower next bound
+    if (!tt_visit(hint_key, g)){
+        return HINT_NOT_FOUND;
+    }
+#endif
+
+    // evaluate every child first, then search the ones closest to the goal
+    // first so the last iteration reaches the goal sooner
+    int children = 0;
+    int child_position[4];
+    int child_h[4];
+    int child_pdb[4]; // 0 without a pattern database
+    for (int k = 0; k < 4; ++k){
+        int position = board_neighbour(blank, k);
+        if (position == NO_TILE || position == prev_blank){
+            continue;
+        }
+        int tile = hint_board[position];
+        int h_next = h - distance_table[tile][position] + distance_table[tile][blank];
+        int pdb_next = 0;
+#if PDB_ENABLED
+        pdb_move(hint_pattern, position);
+        pdb_next = pdb_child_distance(hint_pdb, permutation_rank(hint_pattern, PDB_TILES + 1));
+        pdb_move(hint_pattern, blank);
+#endif
+        int estimate_next = h_next > pdb_next ? h_next : pdb_next;
+        int i = children++;
+        for (; hint_ordered && i > 0 && (child_h[i - 1] > child_pdb[i - 1] ? child_h[i - 1] : child_pdb[i - 1]) > estimate_next; --i){
+            child_position[i] = child_position[i - 1];
+            child_h[i] = child_h[i - 1];
+            child_pdb[i] = child_pdb[i - 1];
+        }
+        child_position[i] = position;
+        child_h[i] = h_next;
+        child_pdb[i] = pdb_next;
+    }
+
+    int next_bound = HINT_NOT_FOUND;
+    for (int c = 0; c < children; ++c){
+        int position = child_position[c];
+        int tile = hint_board[position];
+        int h_next = child_h[c];
+        unsigned long long key = hint_key;
+        int cells = TILE_dimension*TILE_dimension;
+
+        hint_board[blank] = tile;
+        hint_board[position] = NO_TILE;
+        hint_key = key - ((unsigned long long) tile << 4*(cells - 1 - position))
+                       + ((unsigned long long) tile << 4*(cells - 1 - blank));
+#if PDB_ENABLED
+        int pdb = hint_pdb;
+        pdb_move(hint_pattern, position);
+        hint_pdb = child_pdb[c];
+#endif
+        int result = hint_search(position, blank, g + 1, bound, h_next);
+#if PDB_ENABLED
+        pdb_move(hint_pattern, blank);
+        hint_pdb = pdb;
+#endif
+        hint_key = key;
+        hint_board[position] = tile;
+        hint_board[blank] = NO_TILE;
+
+        if (result == HINT_FOUND){
+            solution_moves[g] = position;
+            return HINT_FOUND;
+        }
+        if (result < next_bound){
+            next_bound = result;
+        }
+    }
+    return next_bound;
+}
+
+
+int get_hint(struct game_session* s){
+    if (s->misplaced_tiles == 0 || !board_is_solvable(s)){
+        return NO_TILE;
+    }
+#if HINT_TABLE_ENABLED
+    if (hint_table_ready){
+        return hint_table_move(s->game_tile_positions);
+    }
+#endif
+
+    unsigned long long key = board_key(s->game_tile_positions);
+    int slot = key_hash(key, HINT_CACHE_BITS);
+    if (hint_cache_key[slot] == key){
+        return hint_cache_move[slot];
+    }
+
+    // a player taking the hints stays on the solver's path, only a board off
+    // it is searched again
+    int position = solver_next_move(hint_solver, s->game_tile_positions);
+    hint_cache_key[slot] = key;
+    hint_cache_move[slot] = position;
+    return position;
+}
+
+
+// the board must be solvable, otherwise the search never ends
+int solve_board(int board[]){
+    int no_tile_position = 0;
+    int manhattan_distance = 0;
+    for (int i = 0; i < TILE_dimension*TILE_dimension; ++i){
+        hint_board[i] = board[i];
+        if (board[i] == NO_TILE){
+            no_tile_position = i;
+        } else {
+            manhattan_distance += distance_table[board[i]][i];
+        }
+    }
+#if BIBFS_ENABLED
+    int bidirectional_length = solve_board_bidirectional(board, no_tile_position);
+    if (bidirectional_length >= 0){
+        return bidirectional_length;
+    }
+#endif
+    hint_key = board_key(hint_board);
+    // iterative deepening starting from the manhattan lower bound
+    int bound = SOLVER_WEIGHT*manhattan_distance;
+#if PDB_ENABLED
+    pdb_pattern(hint_board, hint_pattern);
+    hint_pdb = pdb_distance(hint_pattern);
+    if (hint_pdb > manhattan_distance){
+        bound = SOLVER_WEIGHT*hint_pdb;
+    }
+#endif
+    while (bound != HINT_FOUND){
+#if TT_ENABLED
+        tt_iteration++;
+#endif
+        bound = hint_search(no_tile_position, NO_TILE, 0, bound, manhattan_distance);
+    }
+    return solution_length;
+}
+
+
+void solver_pool_init(){
+    solver_free_list = NULL;
+    for (int i = MAX_SOLVERS - 1; i >= 0; --i){
+        solver_pool[i].next_free = solver_free_list;
+        solver_free_list = &solver_pool[i];
+    }
+}
+
+
+struct solver* solver_create(){
+    struct solver* solver = solver_free_list;
+    if (solver == NULL){
+        return NULL;
+    }
+    solver_free_list = solver->next_free;
+    solver->key = 0; // no board packs to 0, the first call always solves
+    solver->length = -1;
+    solver->next = 0;
+    return solver;
+}
+
+
+void solver_destroy(struct solver* solver){
+    solver->next_free = solver_free_list;
+    solver_free_list = solver;
+}
+
+
+int solver_solve(struct solver* solver, int board[]){
+    solver->key = board_key(board);
+    solver->next = 0;
+    if (board_validate(board) != BOARD_VALID){
+        solver->length = -1;
+        return -1;
+    }
+    solver->length = solve_board(board);
+    memcpy(solver->moves, solution_moves, solver->length*sizeof(int));
+    return solver->length;
+}
+
+
+// follows the stored path while the board is the one the last move led to,
+// any other board is solved again
+int solver_next_move(struct solver* solver, int board[]){
+    if (board_key(board) != solver->key){
+        solver_solve(solver, board);
+    }
+    if (solver->length < 0 || solver->next == solver->length){
+        return NO_TILE;
+    }
+    int position = solver->moves[solver->next++];
+    int blank = 0;
+    while (board[blank] != NO_TILE){
+        blank++;
+    }
+    int cells = TILE_dimension*TILE_dimension;
+    unsigned long long tile = board[position];
+    solver->key = solver->key - (tile << 4*(cells - 1 - position)) + (tile << 4*(cells - 1 - blank));
+    return position;
+}
+
+
+int solver_distance(struct solver* solver, int board[]){
+    if (board_key(board) != solver->key){
+        solver_solve(solver, board);
+    }
+    return solver->length < 0 ? -1 : solver->length - solver->next;
+}
+
+
+#if TT_ENABLED
+// replaces a free entry if there is one, otherwise the one reached with the
+// most moves, which prunes the least
+bool tt_visit(unsigned long long key, int g){
+    int index = key_hash(key, TT_BUCKET_BITS);
+    struct tt_entry* entries = tt_table[index].entries;
+    struct tt_entry* victim = &entries[0];
+    tt_probes++;
+    for (int i = 0; i < TT_BUCKET_ENTRIES; ++i){
+        struct tt_entry* entry = &entries[i];
+        if (entry->iteration != tt_iteration){
+            if (victim->iteration == tt_iteration){
+                victim = entry;
+            }
+            continue;
+        }
+        if (entry->key == key){
+            if (entry->g <= g){
+                tt_hits++;
+                return false;
+            }
+            entry->g = g;
+            return true;
+        }
+        if (victim->iteration == tt_iteration && entry->g > victim->g){
+            victim = entry;
+        }
+    }
+    victim->key = key;
+    victim->iteration = tt_iteration;
+    victim->g = g;
+    return true;
+}
+#endif
+
+
+#if BIBFS_ENABLED
+int bibfs_find(struct bibfs_side* side, unsigned long long key){
+    int mask = (1 << BIBFS_HASH_BITS) - 1;
+    int slot = key_hash(key, BIBFS_HASH_BITS);
+    while ((side->hash[slot] >> BIBFS_HASH_BITS) == side->generation){
+        int node = (side->hash[slot] & ((1 << BIBFS_HASH_BITS) - 1)) - 1;
+        if (side->nodes[node].key == key){
+            return node;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return -1;
+}
+
+
+// the key must not be in the side yet
+int bibfs_add(struct bibfs_side* side, unsigned long long key, int parent, int blank){
+    if (side->count == BIBFS_MAX_NODES){
+        return -1;
+    }
+    int mask = (1 << BIBFS_HASH_BITS) - 1;
+    int slot = key_hash(key, BIBFS_HASH_BITS);
+    while ((side->hash[slot] >> BIBFS_HASH_BITS) == side->generation){
+        slot = (slot + 1) & mask;
+    }
+    struct bibfs_node* node = &side->nodes[side->count];
+    node->key = key;
+    node->parent = parent;
+    node->blank = blank;
+    node->depth = parent < 0 ? 0 : side->nodes[parent].depth + 1;
+    side->hash[slot] = side->generation << BIBFS_HASH_BITS | ++side->count;
+    solver_nodes++;
+    return side->count - 1;
+}
+
+
+// expands a whole level of the side with the smaller frontier at a time; the
+// first level that touches the other side holds the shortest path, as long as
+// the shortest meeting in that level is taken
+int solve_board_bidirectional(int board[], int no_tile_position){
+    int cells = TILE_dimension*TILE_dimension;
+    int goal[TILE_dimension*TILE_dimension];
+    for (int i = 0; i < cells; ++i){
+        goal[i] = i == cells - 1 ? NO_TILE : i + 1;
+    }
+    for (int d = 0; d < 2; ++d){
+        // generation 0 is what the zeroed table starts as, it is never used
+        bibfs_sides[d].generation = (bibfs_sides[d].generation + 1) % BIBFS_GENERATIONS;
+        if (bibfs_sides[d].generation == 0){
+            memset(bibfs_sides[d].hash, 0, sizeof(bibfs_sides[d].hash));
+            bibfs_sides[d].generation = 1;
+        }
+        bibfs_sides[d].count = 0;
+        bibfs_sides[d].level_start = 0;
+    }
+    bibfs_add(&bibfs_sides[0], board_key(board), -1, no_tile_position);
+    bibfs_add(&bibfs_sides[1], board_key(goal), -1, cells - 1);
+    if (bibfs_sides[0].nodes[0].key == bibfs_sides[1].nodes[0].key){
+        return 0;
+    }
+
+    int best = -1;
+    int meet[2];
+    while (best < 0){
+        int d = bibfs_sides[0].count - bibfs_sides[0].level_start <=
+                bibfs_sides[1].count - bibfs_sides[1].level_start ? 0 : 1;
+        struct bibfs_side* side = &bibfs_sides[d];
+        struct bibfs_side* other = &bibfs_sides[1 - d];
+        int level_end = side->count;
+        if (side->level_start == level_end){
+            return -1; // nothing left to expand, the board is unsolvable
+        }
+
+        for (int i = side->level_start; i < level_end; ++i){
+            unsigned long long key = side->nodes[i].key;
+            int blank = side->nodes[i].blank;
+            for (int k = 0; k < 4; ++k){
+                int position = board_neighbour(blank, k);
+                if (position == NO_TILE){
+                    continue;
+                }
+                // the tile at position takes the blank's place in the key
+                int from_shift = 4*(cells - 1 - position);
+                int to_shift = 4*(cells - 1 - blank);
+                unsigned long long tile = (key >> from_shift) & 0xF;
+                unsigned long long next = key - (tile << from_shift) + (tile << to_shift);
+                if (bibfs_find(side, next) >= 0){
+                    continue;
+                }
+                int node = bibfs_add(side, next, i, position);
+                if (node < 0){
+                    return -1;
+                }
+                int match = bibfs_find(other, next);
+                if (match >= 0){
+                    int length = side->nodes[node].depth + other->nodes[match].depth;
+                    if (best < 0 || length < best){
+                        best = length;
+                        meet[d] = node;
+                        meet[1 - d] = match;
+                    }
+                }
+            }
+        }
+        side->level_start = level_end;
+    }
+
+    // each move is the position the blank moves to: walk back to the board,
+    // then forward to the goal
+    struct bibfs_node* nodes = bibfs_sides[0].nodes;
+    for (int n = meet[0]; nodes[n].parent >= 0; n = nodes[n].parent){
+        solution_moves[nodes[n].depth - 1] = nodes[n].blank;
+    }
+    int step = nodes[meet[0]].depth;
+    nodes = bibfs_sides[1].nodes;
+    for (int n = nodes[meet[1]].parent; n >= 0; n = nodes[n].parent){
+        solution_moves[step++] = nodes[n].blank;
+    }
+    return best;
+}
+#endif
+
+
+#if PDB_ENABLED
+// an entry is the distance of the pattern from its goal, counting every move
+// of the no tile. That is never more than the moves of the whole board, and
+// as with whole boards the neighbours of a pattern differ from it by one
+// move, which lets the 2 bit encoding recover the distance from its value mod 3
+void pdb_init(){
+    memset(pdb_table, 0xFF, sizeof(pdb_table));
+    int pattern[PDB_TILES + 1];
+    for (int i = 0; i <= PDB_TILES; ++i){
+        pattern[i] = i == 0 ? PDB_CELLS - 1 : i - 1;
+    }
+    pdb_goal_rank = permutation_rank(pattern, PDB_TILES + 1);
+    pdb_set(pdb_goal_rank, 0);
+    pdb_queue[0] = pdb_goal_rank;
+    int head = 0;
+    int tail = 1;
+    int level_end = 1;
+    int distance = 0;
+    while (head < tail){
+        if (head == level_end){
+            distance++;
+            level_end = tail;
+        }
+        permutation_unrank(pdb_queue[head++], pattern, PDB_TILES + 1);
+        int blank = pattern[0];
+        for (int k = 0; k < 4; ++k){
+            int position = board_neighbour(blank, k);
+            if (position == NO_TILE){
+                continue;
+            }
+            pdb_move(pattern, position);
+            unsigned int rank = permutation_rank(pattern, PDB_TILES + 1);
+            if (pdb_get(rank) == PDB_EMPTY){
+                pdb_set(rank, distance + 1);
+                pdb_queue[tail++] = rank;
+            }
+            pdb_move(pattern, blank);
+        }
+    }
+    printf("pattern database: %d entries in %d bytes, farthest %d moves\n",
+           tail, (int) sizeof(pdb_table), distance);
+}
+
+
+int pdb_get(unsigned int rank){
+#if PDB_BITS == 2
+    return (pdb_table[rank >> 2] >> 2*(rank & 3)) & 3;
+#else
+    return (pdb_table[rank >> 1] >> 4*(rank & 1)) & 0xF;
+#endif
+}
+
+
+void pdb_set(unsigned int rank, int distance){
+#if PDB_BITS == 2
+    int shift = 2*(rank & 3);
+    pdb_table[rank >> 2] = (pdb_table[rank >> 2] & ~(3 << shift)) | (distance % 3) << shift;
+#else
+    int shift = 4*(rank & 1);
+    if (distance > PDB_EMPTY - 1){
+        distance = PDB_EMPTY - 1; // still a lower bound
+    }
+    pdb_table[rank >> 1] = (pdb_table[rank >> 1] & ~(0xF << shift)) | distance << shift;
+#endif
+}
+
+
+void pdb_pattern(int board[], int pattern[]){
+    for (int i = 0; i < PDB_CELLS; ++i){
+        if (board[i] == NO_TILE){
+            pattern[0] = i;
+        } else if (board[i] <= PDB_TILES){
+            pattern[board[i]] = i;
+        }
+    }
+}
+
+
+// a pattern tile at position takes the no tile's place
+void pdb_move(int pattern[], int position){
+    for (int i = 1; i <= PDB_TILES; ++i){
+        if (pattern[i] == position){
+            pattern[i] = pattern[0];
+            break;
+        }
+    }
+    pattern[0] = position;
+}
+
+
+int pdb_distance(int pattern[]){
+    unsigned int rank = permutation_rank(pattern, PDB_TILES + 1);
+#if PDB_BITS == 2
+    // every state but the goal has a neighbour one move closer, the only one
+    // stored as one less mod 3
+    int walk[PDB_TILES + 1];
+    memcpy(walk, pattern, sizeof(walk));
+    int distance = 0;
+    while (rank != pdb_goal_rank){
+        int blank = walk[0];
+        int closer = (pdb_get(rank) + 2) % 3;
+        int k;
+        for (k = 0; k < 4; ++k){
+            int position = board_neighbour(blank, k);
+            if (position == NO_TILE){
+                continue;
+            }
+            pdb_move(walk, position);
+            unsigned int next = permutation_rank(walk, PDB_TILES + 1);
+            if (pdb_get(next) == closer){
+                rank = next;
+                break;
+            }
+            pdb_move(walk, blank);
+        }
+        // no step down, the table is not built: the pattern tiles' manhattan
+        // distance is still a lower bound
+        if (k == 4){
+            distance = 0;
+            for (int i = 1; i <= PDB_TILES; ++i){
+                distance += tile_distance(i, pattern[i]);
+            }
+            return distance;
+        }
+        distance++;
+    }
+    return distance;
+#else
+    return pdb_get(rank);
+#endif
+}
+
+
+int pdb_child_distance(int distance, unsigned int child_rank){
+#if PDB_BITS == 2
+    return (pdb_get(child_rank) - distance % 3 + 3) % 3 == 1 ? distance + 1 : distance - 1;
+#else
+    (void) distance; // a 4 bit entry is the whole distance
+    return pdb_get(child_rank);
+#endif
+}
+#endif
+
+
+#if HINT_TABLE_ENABLED
+// the boards next to one at distance d are at d-1 or d+1, so the value mod 3
+// tells them apart
+void hint_table_init(){
+    int goal[TILE_dimension*TILE_dimension];
+    for (int i = 0; i < TILE_dimension*TILE_dimension; ++i){
+        goal[i] = i == TILE_dimension*TILE_dimension - 1 ? NO_TILE : i + 1;
+    }
+    memset(hint_table, 0xFF, sizeof(hint_table));
+    hint_table_goal = board_rank(goal);
+    hint_table_set(hint_table_goal, 0);
+    hint_table_depth = 0;
+    hint_table_scan = 0;
+    hint_table_added = 0;
+    hint_table_ready = false;
+}
+
+
+// expands layer hint_table_depth by scanning every rank for its value mod 3.
+// Boards 3, 6, ... layers back share the value, but their neighbours are all
+// set already so expanding them again adds nothing. Runs from the main loop
+// with interrupts on, the time limit only keeps the display and demo smooth
+bool hint_table_step(){
+    if (hint_table_ready){
+        return false;
+    }
+    unsigned int start_ms = system_clock_ms();
+    int board[TILE_dimension*TILE_dimension];
+    while (system_clock_ms() - start_ms < HINT_TABLE_FRAME_MS){
+        for (int n = 0; n < 256 && hint_table_scan < HINT_TABLE_ENTRIES; ++n, ++hint_table_scan){
+            if (hint_table_get(hint_table_scan) != hint_table_depth % 3){
+                continue;
+            }
+            board_unrank(hint_table_scan, board);
+            int blank = 0;
+            while (board[blank] != NO_TILE){
+                blank++;
+            }
+            for (int k = 0; k < 4; ++k){
+                int position = board_neighbour(blank, k);
+                if (position == NO_TILE){
+                    continue;
+                }
+                board[blank] = board[position];
+                board[position] = NO_TILE;
+                unsigned int rank = board_rank(board);
+                if (hint_table_get(rank) == HINT_TABLE_EMPTY){
+                    hint_table_set(rank, hint_table_depth + 1);
+                    hint_table_added++;
+                }
+                board[position] = board[blank];
+                board[blank] = NO_TILE;
+            }
+        }
+        if (hint_table_scan == HINT_TABLE_ENTRIES){
+            if (hint_table_added == 0){
+                hint_table_ready = true;
+                printf("hint table ready, %d moves at most\n", hint_table_depth);
+                return false;
+            }
+            hint_table_depth++;
+            hint_table_scan = 0;
+            hint_table_added = 0;
+        }
+    }
+    return true;
+}
+
+
+int hint_table_get(unsigned int rank){
+    return (hint_table[rank >> 2] >> 2*(rank & 3)) & 3;
+}
+
+
+void hint_table_set(unsigned int rank, int distance){
+    int shift = 2*(rank & 3);
+    hint_table[rank >> 2] = (hint_table[rank >> 2] & ~(3 << shift)) | (distance % 3) << shift;
+}
+
+
+// the neighbour stored as one less mod 3 is the one closer to the goal
+int hint_table_advance(int board[]){
+    unsigned int rank = board_rank(board);
+    if (rank == hint_table_goal){
+        return NO_TILE;
+    }
+    int closer = (hint_table_get(rank) + 2) % 3;
+    int blank = 0;
+    while (board[blank] != NO_TILE){
+        blank++;
+    }
+    for (int k = 0; k < 4; ++k){
+        int position = board_neighbour(blank, k);
+        if (position == NO_TILE){
+            continue;
+        }
+        board[blank] = board[position];
+        board[position] = NO_TILE;
+        if (hint_table_get(board_rank(board)) == closer){
+            return position;
+        }
+        board[position] = board[blank];
+        board[blank] = NO_TILE;
+    }
+    return NO_TILE; // only for an unsolvable board
+}
+
+
+int hint_table_move(int board[]){
+    int copy[TILE_dimension*TILE_dimension];
+    memcpy(copy, board, sizeof(copy));
+    return hint_table_advance(copy);
+}
+
+
+// counter() asks on every pass, the walk only runs when the board changed
+int hint_table_distance(int board[]){
+    unsigned long long key = board_key(board);
+    if (key == hint_distance_key){
+        return hint_distance;
+    }
+    int copy[TILE_dimension*TILE_dimension];
+    memcpy(copy, board, sizeof(copy));
+    int distance = 0;
+    while (hint_table_advance(copy) != NO_TILE){
+        distance++;
+    }
+    hint_distance_key = key;
+    hint_distance = distance;
+    return distance;
+}
+#endif
+
+
+#if BENCHMARK_ENABLED
+// runs with whatever solvers this build has switched on, the JSON line
+// records which so the results of different builds can be compared
+void solver_benchmark(){
+    int board[TILE_dimension*TILE_dimension];
+    int total_moves = 0;
+    unsigned long long total_nodes = 0;
+    unsigned int total_ms = 0;
+    unsigned int worst_ms = 0;
+    unsigned long long probes = 0; // transposition table lookups, 0 without TT_ENABLED
+    unsigned long long hits = 0;
+    int memory = sizeof(distance_table) + sizeof(hint_board) + sizeof(solution_moves);
+#if TT_ENABLED
+    memory += sizeof(tt_table);
+#endif
+#if BIBFS_ENABLED
+    memory += sizeof(bibfs_sides);
+#endif
+#if PDB_ENABLED
+    memory += sizeof(pdb_table); // pdb_queue is only used while the table is built
+#endif
+
+    srand(BENCHMARK_SEED);
+    printf("board   moves        nodes       ms\n");
+    for (int i = 0; i < BENCHMARK_BOARDS; ++i){
+        random_board(board);
+        if (board_validate(board) == BOARD_UNSOLVABLE){
+            board_repair(board);
+        }
+        solver_nodes = 0;
+#if TT_ENABLED
+        tt_probes = 0;
+        tt_hits = 0;
+#endif
+        unsigned int start_ms = system_clock_ms();
+        int moves = solve_board(board);
+        unsigned int elapsed_ms = system_clock_ms() - start_ms;
+#if TT_ENABLED
+        probes += tt_probes;
+        hits += tt_hits;
+#endif
+        printf("%5d %7d %12llu %8u\n", i, moves, solver_nodes, elapsed_ms);
+        total_moves += moves;
+        total_nodes += solver_nodes;
+        total_ms += elapsed_ms;
+        if (elapsed_ms > worst_ms){
+            worst_ms = elapsed_ms;
+        }
+    }
+    unsigned int nodes_per_s = total_ms == 0 ? 0 : (unsigned int)(total_nodes*1000/total_ms);
+    printf("total %7d %12llu %8u, %u nodes/s, %u ms worst, %d bytes of solver tables\n",
+           total_moves, total_nodes, total_ms, nodes_per_s, worst_ms, memory);
+#if TT_ENABLED
+    unsigned int hit_permille = probes == 0 ? 0 : (unsigned int)(hits*1000/probes);
+    printf("transposition table: %llu probes, %llu hits, %u.%u%% hit rate\n",
+           probes, hits, hit_permille/10, hit_permille%10);
+#endif
+    printf("{\"board_size\":%d,\"boards\":%d,\"seed\":%d,\"weight\":%d,\"tt\":%d,\"bibfs\":%d,"
+           "\"pdb_bits\":%d,\"moves\":%d,\"nodes\":%llu,\"ms\":%u,\"worst_ms\":%u,"
+           "\"nodes_per_s\":%u,\"memory_bytes\":%d,\"tt_probes\":%llu,\"tt_hits\":%llu}\n",
+           TILE_dimension, BENCHMARK_BOARDS, BENCHMARK_SEED, SOLVER_WEIGHT, TT_ENABLED, BIBFS_ENABLED,
+           PDB_ENABLED ? PDB_BITS : 0, total_moves, total_nodes, total_ms, worst_ms, nodes_per_s, memory, probes, hits);
+}
+#endif
+
+
+#if LAYER_STATS_ENABLED
+void layer_stats_start(){
+    int cells = TILE_dimension*TILE_dimension;
+    int goal[TILE_dimension*TILE_dimension];
+    for (int i = 0; i < cells; ++i){
+        goal[i] = i == cells - 1 ? NO_TILE : i + 1;
+    }
+    layer_previous = 0;
+    layer_size[0] = 0;
+    layer_size[1] = 1;
+    layer_states[1][0] = board_key(goal);
+    layer_depth = 0;
+    layer_total = 1;
+    layer_elapsed_ms = 0;
+    layer_done = false;
+    printf("distance 0: 1 boards\n");
+}
+
+
+int compare_keys(const void* a, const void* b){
+    unsigned long long x = *(const unsigned long long*) a;
+    unsigned long long y = *(const unsigned long long*) b;
+    return x < y ? -1 : x > y;
+}
+
+
+// one layer per call so the game keeps running in between; the enumeration
+// lives in the globals and picks up where it stopped on the next call
+bool layer_stats_step(){
+    if (layer_done){
+        return false;
+    }
+    unsigned int start_ms = system_clock_ms();
+    int cells = TILE_dimension*TILE_dimension;
+    int current = 1 - layer_previous;
+    unsigned long long* states = layer_states[current];
+    int candidates = 0;
+    for (int i = 0; i < layer_size[current]; ++i){
+        unsigned long long key = states[i];
+        int blank = 0;
+        while (((key >> 4*(cells - 1 - blank)) & 0xF) != 0){
+            blank++;
+        }
+        for (int k = 0; k < 4; ++k){
+            int position = board_neighbour(blank, k);
+            if (position == NO_TILE){
+                continue;
+            }
+            int from_shift = 4*(cells - 1 - position);
+            int to_shift = 4*(cells - 1 - blank);
+            unsigned long long tile = (key >> from_shift) & 0xF;
+            layer_candidates[candidates++] = key - (tile << from_shift) + (tile << to_shift);
+        }
+    }
+    qsort(layer_candidates, candidates, sizeof(unsigned long long), compare_keys);
+
+    // merge the sorted children against the previous layer, keeping each new
+    // board once; the kept ones are compacted to the front in order
+    unsigned long long* previous = layer_states[layer_previous];
+    int previous_size = layer_size[layer_previous];
+    int p = 0;
+    int size = 0;
+    for (int i = 0; i < candidates; ++i){
+        unsigned long long key = layer_candidates[i];
+        if (size > 0 && key == layer_candidates[size - 1]){
+            continue;
+        }
+        while (p < previous_size && previous[p] < key){
+            p++;
+        }
+        if (p < previous_size && previous[p] == key){
+            continue;
+        }
+        layer_candidates[size++] = key;
+    }
+    if (size > LAYER_MAX_STATES){
+        printf("distance %d has %d boards, more than %d, stopped\n", layer_depth + 1, size, LAYER_MAX_STATES);
+        layer_done = true;
+        return false;
     }
-  	
-    for (int k = 0; k < 9; ++k){
-       draw_tile(k);
+    layer_elapsed_ms += system_clock_ms() - start_ms;
+
+    if (size == 0){
+        printf("%u boards, farthest %d moves from the goal, %u ms\n", layer_total, layer_depth, layer_elapsed_ms);
+        layer_done = true;
+        return false;
     }
+    // the new layer replaces the previous one, which is no longer needed
+    memcpy(previous, layer_candidates, size*sizeof(unsigned long long));
+    layer_size[layer_previous] = size;
+    layer_previous = current;
+    layer_depth++;
+    layer_total += size;
+    printf("distance %d: %d boards, %u total, %u boards/s\n", layer_depth, size, layer_total,
+           layer_elapsed_ms == 0 ? 0 : (unsigned int)(layer_total*1000ULL/layer_elapsed_ms));
+    return true;
+}
+#endif
 
-    reset_selected_tile();
 
+// only the header is checked here, boards are validated as they are loaded
+bool corpus_open(const struct corpus_header* header){
+    corpus_count = 0;
+    if (header->magic != CORPUS_MAGIC || header->board_size != TILE_dimension ||
+        header->buckets != CORPUS_BUCKETS || header->bucket_start[0] != 0 ||
+        header->bucket_start[CORPUS_BUCKETS] != header->count){
+        printf("corpus header rejected\n");
+        return false;
+    }
+    for (int b = 0; b < CORPUS_BUCKETS; ++b){
+        if (header->bucket_start[b] > header->bucket_start[b + 1]){
+            printf("corpus header rejected\n");
+            return false;
+        }
+    }
+    corpus = header;
+    corpus_records = (const struct corpus_record*) (header + 1);
+    corpus_count = header->count;
+    return true;
 }
 
 
-void new_game_board(int array1[], int array2[])
-{
-	for(int i=0;i<9;i++)
-		{
-			array1[i]=array2[i];
-            if (array2[i] == NO_TILE){
-                no_tile_position = i;
-            }
-		}
+void corpus_board(int index, int board[]){
+    unsigned long long key = corpus_records[index].board;
+    for (int i = TILE_dimension*TILE_dimension - 1; i >= 0; --i){
+        int tile = key & 0xF;
+        board[i] = tile == 0 ? NO_TILE : tile;
+        key >>= 4;
+    }
 }
 
 
-// swap tile at selected position with no tile position
-void swap_tile(){
+// record 0 is a real board, so an empty bucket is -1 and the caller decides
+int corpus_pick(int difficulty){
+    if (corpus_count == 0 || difficulty < 0 || difficulty >= CORPUS_BUCKETS){
+        return -1;
+    }
+    int first = corpus->bucket_start[difficulty];
+    int size = corpus->bucket_start[difficulty + 1] - first;
+    return size == 0 ? -1 : first + rand() % size;
+}
 
-    // animate tile swapping
-    animate_swap_tile();
 
-    // swap selected tile and no tile positions
-    game_tile_positions[no_tile_position] = game_tile_positions[selected_tile_position];
-    game_tile_positions[selected_tile_position] = NO_TILE;
+unsigned short score_checksum(struct score_record* r){
+    unsigned int sum = SCORE_CHECK_SEED;
+    sum = sum*31 + r->board;
+    sum = sum*31 + r->moves;
+    sum = sum*31 + (r->elapsed_ms & 0xFFFF);
+    sum = sum*31 + (r->elapsed_ms >> 16);
+    sum = sum*31 + r->player;
+    return (sum ^ (sum >> 16)) & 0xFFFF;
+}
 
-    // set global variable no tile position to selected position
-    int temp = no_tile_position;
-    no_tile_position = selected_tile_position;
-    selected_tile_position = temp;
-    draw_selected_tile_frame(false);
-	check_game_status();
+
+void leaderboard_load(){
+    if (score_store->magic != SCORE_STORE_MAGIC || score_store->active > 1){
+        score_store->logs[0][0].board = SCORE_NO_BOARD;
+        score_store->logs[1][0].board = SCORE_NO_BOARD;
+        score_store->active = 0;
+        __sync_synchronize();
+        score_store->magic = SCORE_STORE_MAGIC;
+    }
+    score_log = score_store->logs[score_store->active];
+    for (int b = 0; b < LEADERBOARD_BOARDS; ++b){
+        leaderboard_count[b] = 0;
+    }
+    int length = 0;
+    while (length < SCORE_LOG_SIZE && score_log[length].check == score_checksum(&score_log[length])
+           && score_log[length].board < LEADERBOARD_BOARDS){
+        leaderboard_insert(length);
+        ++length;
+    }
+    score_log_length = length;
 }
 
 
-// reset selected tile and redraw the frame
-void reset_selected_tile(){
-    // set new selected tile
-    int selectable_tiles[4];
-    int temp1, temp2;
-    get_selectable_tiles(selectable_tiles, &temp1, &temp2);
-    selected_tile_position = selectable_tiles[0];
-    // draw frame
-    draw_selected_tile_frame(false);
+// the slot is marked free while it is written and gets its board last; the
+// slot after it may still hold a valid record from before a compaction, so
+// it is freed first to end the log there
+bool leaderboard_append(int board, int moves, unsigned int elapsed_ms, int player){
+    if (board < 0 || board >= LEADERBOARD_BOARDS){
+        return false;
+    }
+    if (score_log_length == SCORE_LOG_SIZE){
+        leaderboard_compact();
+    }
+    struct score_record record = {board, moves, elapsed_ms, player, 0};
+    record.check = score_checksum(&record);
+    struct score_record* r = &score_log[score_log_length];
+    r->board = SCORE_NO_BOARD;
+    if (score_log_length + 1 < SCORE_LOG_SIZE){
+        score_log[score_log_length + 1].board = SCORE_NO_BOARD;
+    }
+    __sync_synchronize();
+    r->moves = record.moves;
+    r->elapsed_ms = record.elapsed_ms;
+    r->player = record.player;
+    r->check = record.check;
+    __sync_synchronize();
+    r->board = record.board;
+    leaderboard_insert(score_log_length);
+    ++score_log_length;
+    return true;
 }
 
 
-// animate the motion of tile moving from selected tile position -> no tile position
-void animate_swap_tile(){
-    volatile int * pixel_ctrl_ptr = (int *)0xFF203020;
+// faster time wins, fewer moves breaks ties; earlier records stay ahead of equal ones
+void leaderboard_insert(int record){
+    struct score_record* r = &score_log[record];
+    int* top = leaderboard_index[r->board];
+    int count = leaderboard_count[r->board];
+    int i = count;
+    while (i > 0){
+        struct score_record* other = &score_log[top[i - 1]];
+        if (other->elapsed_ms < r->elapsed_ms ||
+            (other->elapsed_ms == r->elapsed_ms && other->moves <= r->moves)){
+            break;
+        }
+        if (i < LEADERBOARD_TOP){
+            top[i] = top[i - 1];
+        }
+        --i;
+    }
+    if (i < LEADERBOARD_TOP){
+        top[i] = record;
+        if (count < LEADERBOARD_TOP){
+            leaderboard_count[r->board] = count + 1;
+        }
+    }
+}
 
-    int row_selected = selected_tile_position % 3;
-    int col_selected = selected_tile_position / 3;
-    int row_no_tile = no_tile_position % 3;
-    int col_no_tile = no_tile_position / 3;
 
-    // determine how much to move by
-    int anim_x = 0;
-    int anim_y = 0;
-    if (row_no_tile == row_selected){
-        if (col_no_tile > col_selected){
-            anim_y = 15;
-        } else if (col_no_tile < col_selected){
-            anim_y = -15;
+// the active log is only read, a reset before the switch keeps it as it was
+void leaderboard_compact(){
+    bool keep[SCORE_LOG_SIZE] = {false};
+    for (int b = 0; b < LEADERBOARD_BOARDS; ++b){
+        for (int i = 0; i < leaderboard_count[b]; ++i){
+            keep[leaderboard_index[b][i]] = true;
         }
-    } else if (col_no_tile == col_selected){
-        if (row_no_tile > row_selected){
-            anim_x = 20;
-        } else if (row_no_tile < row_selected){
-            anim_x = -20;
+    }
+    struct score_record* compacted = score_store->logs[1 - score_store->active];
+    int length = 0;
+    for (int i = 0; i < score_log_length; ++i){
+        if (keep[i]){
+            compacted[length++] = score_log[i];
         }
     }
+    if (length < SCORE_LOG_SIZE){
+        compacted[length].board = SCORE_NO_BOARD;
+    }
+    __sync_synchronize();
+    score_store->active = 1 - score_store->active;
+    leaderboard_load();
+}
 
-    // current x and y values of selected tile
-    int x_selected = 12 + row_selected*100;
-    int y_selected = 12 + col_selected*75;
-    // erase selected tile
-    drawing_png(x_selected, y_selected, get_png_of_tile(NO_TILE), x_selected);
-    x_selected += anim_x;
-    y_selected += anim_y;
 
-    while(1){
-        // draw
-        drawing_png(x_selected, y_selected, 
-                    get_png_of_tile(game_tile_positions[selected_tile_position]),
-                    x_selected);
+int leaderboard_top(int board, struct score_record* scores[], int n){
+    if (board < 0 || board >= LEADERBOARD_BOARDS){
+        return 0;
+    }
+    if (n > leaderboard_count[board]){
+        n = leaderboard_count[board];
+    }
+    for (int i = 0; i < n; ++i){
+        scores[i] = &score_log[leaderboard_index[board][i]];
+    }
+    return n;
+}
 
-        if (anim_x != 0 && (x_selected == 12 + row_no_tile *100)){
-            break;
-        } 
-        if (anim_y != 0 && (y_selected == 12 + col_no_tile *75)){
-            break;
-        }
 
-        wait_for_vsync();        
-        pixel_buffer_start = *(pixel_ctrl_ptr + 1); // new back buffer
+// to the JTAG UART, the VGA is showing the win page
+void leaderboard_print(int board){
+    struct score_record* scores[LEADERBOARD_TOP];
+    int n = leaderboard_top(board, scores, LEADERBOARD_TOP);
+    printf("board %d best times\n", board);
+    for (int i = 0; i < n; ++i){
+        printf("%d. player %4d %4u.%03u s %3d moves\n", i + 1, scores[i]->player,
+               scores[i]->elapsed_ms/1000, scores[i]->elapsed_ms%1000, scores[i]->moves);
+    }
+}
+
+
+void demo_start(){
+    demo_mode = true;
+    srand(system_clock_ms());
+    demo_next_board();
+}
 
-        // erase
-        drawing_png(x_selected, y_selected, get_png_of_tile(NO_TILE), x_selected);
-        // move
-        x_selected += anim_x;
-        y_selected += anim_y;
 
+void demo_step(){
+    if ((int)(system_clock_ms() - demo_next_move_ms) < 0){
+        return;
     }
+    cursor_hide();
+    if (solver_distance(demo_solver, game->game_tile_positions) == 0){
+        demo_next_board();
+        cursor_show();
+        return;
+    }
+
+    // play the move through the same path as the Enter key
+    draw_selected_tile_frame(true);
+    game->selected_tile_position = solver_next_move(demo_solver, game->game_tile_positions);
+    swap_tile();
+    cursor_show();
+
+    demo_next_move_ms = system_clock_ms() +
+                        (solver_distance(demo_solver, game->game_tile_positions) == 0 ? DEMO_BOARD_PAUSE_MS : DEMO_MOVE_MS);
 }
 
 
-void check_game_status()
-{
-	int count=0;
-	for(int i=0; i<9;i++)
-	{
-		if(game_tile_positions[i]==i+1)
-		{
-			count++;
-		}
-	}
+void demo_next_board(){
+    int board[TILE_dimension*TILE_dimension];
 
-	if(count==8)
-	{
-        game_over = true;
-		clear_screen();
-		drawing_png2(80,40,win,80);
-	}
-	
+    if (game->game_over){
+        game->game_over = false;
+        clear_screen();
+    }
+    game = session_recycle(game);
+    game_clock_reset(game);
+    game->board_number = NO_BOARD;
+
+    // half of the random boards are unsolvable, new_game_board() repairs them
+    random_board(board);
+    new_game_board(game, board);
+
+    // solve fully before the first frame, so playback never waits on the solver
+    solver_solve(demo_solver, game->game_tile_positions);
+
+    for (int k = 0; k < TILE_dimension*TILE_dimension; ++k){
+       draw_tile(k);
+    }
+    reset_selected_tile();
+    demo_next_move_ms = system_clock_ms() + DEMO_MOVE_MS;
+}
+
+
+// uniformly shuffled tiles, may be unsolvable
+void random_board(int board[]){
+    int size = TILE_dimension*TILE_dimension;
+    for (int i = 0; i < size - 1; ++i){
+        board[i] = i + 1;
+    }
+    board[size - 1] = NO_TILE;
+    for (int i = size - 1; i > 0; --i){
+        int j = rand() % (i + 1);
+        int temp = board[i];
+        board[i] = board[j];
+        board[j] = temp;
+    }
+}
+
+
+void show_hint(){
+    if (game->game_over){
+        return;
+    }
+    int position = get_hint(game);
+    if (position == NO_TILE){
+        return;
+    }
+    draw_selected_tile_frame(true);
+    game->selected_tile_position = position;
+    draw_selected_tile_frame(false);
 }
 
 
 void counter()
 {
-	volatile int * HEX3_0_ptr = (int*) 0xFF200020;
-    char seg7[] = {0x3f, 0x06, 0x5b, 0x4f, 0x66, 0x6d, 0x7d, 0x07, 0x7f, 0x67, 0x77, 
-					0x7c, 0x39, 0x5e, 0x79, 0x71};
     int value1;
 	int value2;
 	int value3;
@@ -494,25 +2858,127 @@ void counter()
 	int inter2;
 	int second;
 	// int minute;
-	while(count<=180)
+	// keep refreshing while the win/lose page is up, the clock is frozen then;
+	// the demo plays its boards without limits. The limit is a flag set by
+	// session_move() and the timer ISR, the loop never reads the clock for it
+	while(demo_mode || !session_limit_reached(game))
 	{
+		count = game_clock_ms(game)/1000;
+		if (mode.countdown){
+			int limit = mode.time_limit_ms/1000;
+			count = count < limit ? limit - count : 0;
+		}
 		second=((count % 3600) % 60);
 		// minute=(second % 3600)/60;
 		value1 = second%10;
 		inter = second/10;
 		value2 = inter%10;
 		inter2 = count/60;
-		value3= inter2;
+		value3= inter2%10;
 		//value3 = value%1000;
 		
-		*(HEX3_0_ptr) = seg7[value1] | seg7[value2] << 8 | 
-			seg7[value3] << 16;
+		// moves or boards left on HEX5-4, moves to solved if neither is limited,
+		// estimated until the hint table is complete
+		int left = board_distance(game);
+#if HINT_TABLE_ENABLED
+		if (hint_table_ready && board_is_solvable(game)){
+			left = hint_table_distance(game->game_tile_positions);
+		}
+#endif
+		if (mode.move_limit != NO_LIMIT){
+			left = mode.move_limit - game->moves;
+		} else if (mode.boards > 1){
+			left = mode.boards - boards_solved;
+		}
+		display_on_hex(value1, value2, value3, 16, left%10, (left/10)%10);
+		
+		// only from the win or lose page, a player thinking over a board keeps it
+		if (!demo_mode && game->game_over && system_clock_ms() - last_input_ms > DEMO_IDLE_MS){
+			demo_toggle_requested = true;
+		}
+		if (demo_toggle_requested){
+			demo_toggle_requested = false;
+			cursor_hide();
+			if (demo_mode){
+				demo_mode = false;
+				shuffle();
+			} else {
+				demo_start();
+			}
+			cursor_show();
+		}
+		if (demo_mode){
+			demo_step();
+		}
+#if HINT_TABLE_ENABLED
+		hint_table_step();
+#endif
+#if LAYER_STATS_ENABLED
+		layer_stats_step();
+#endif
 		
+#if PROFILE_ENABLED
+		profile_drain();
+		if (profile_dump_requested){
+			profile_dump_requested = false;
+			profile_dump();
+		}
+#endif
 	}
-    game_over = true;
-	count=0; 
+	game_clock_pause(game);
+    game->game_over = true;
+	cursor_hide();
 	clear_screen();
 	drawing_png2(80,40,lose,80);
+	cursor_show();
+}
+
+
+// reads the period count together with the timer snapshot registers, so the
+// result has 1 ms resolution and stays exact while IRQs are masked
+unsigned int system_clock_ms(){
+	volatile int * interval_timer_ptr = (int *)TIMER_BASE;
+	unsigned int periods;
+	unsigned int remaining;
+	int status;
+	int status_after;
+
+	do {
+		periods = clock_periods;
+		status = *(interval_timer_ptr) & 0x1;
+		*(interval_timer_ptr + 0x4) = 0; // latch the counter into snapl/snaph
+		remaining = (*(interval_timer_ptr + 0x4) & 0xFFFF) |
+					(*(interval_timer_ptr + 0x5) & 0xFFFF) << 16;
+		status_after = *(interval_timer_ptr) & 0x1;
+		// retry if the timer wrapped or the ISR ran while we were reading
+	} while (status != status_after || periods != clock_periods);
+
+	// a timeout still pending (IRQs masked) has not been counted by the ISR yet
+	if (status){
+		periods++;
+	}
+	return periods*TIMER_MS_PER_PERIOD + (TIMER_PERIOD - 1 - remaining)/TIMER_CYCLES_PER_MS;
+}
+
+
+unsigned int game_clock_ms(struct game_session* s){
+	if (s->game_over){
+		return s->end_ms - s->start_ms;
+	}
+	return system_clock_ms() - s->start_ms;
+}
+
+
+void game_clock_reset(struct game_session* s){
+	s->start_ms = system_clock_ms();
+	s->end_ms = s->start_ms;
+	s->deadline_ms = s->start_ms + mode.time_limit_ms;
+	s->limit_reached = false;
+}
+
+
+void game_clock_pause(struct game_session* s){
+	s->end_ms = system_clock_ms();
 }
 
 
@@ -565,24 +3031,11 @@ void wait_for_vsync () {
 // selects new right or left tile, updtes selected tile position and draw frame around it
 // direction_offset = -1 for left, +1 for right
 void select_new_selected_tile(int direction_offset){
-    int selectable_tiles[4]; // array of selectable tile position
-    int selectable_tiles_num; // number of tiles selectable
-    int current_select_index; // index of currently selected tile wrt selectable_tiles array
-
-    get_selectable_tiles(selectable_tiles, &selectable_tiles_num, &current_select_index);
-    int select_index = current_select_index + direction_offset;
-
-    if (select_index < 0) {
-        select_index = selectable_tiles_num-1;
-    } if (select_index >= selectable_tiles_num) {
-        select_index = 0;
-    }
-
     // erase current frame
     draw_selected_tile_frame(true);
 
     // set new tile position and draw frame
-    selected_tile_position = selectable_tiles[select_index];
+    session_select(game, direction_offset);
     draw_selected_tile_frame(false);
 
 }
@@ -591,49 +3044,24 @@ void select_new_selected_tile(int direction_offset){
 // returns array of tile numbers that are selectable by users
 // change the parameter selectale_tiles to the array
 // and puts the number of selectable tiles into size
-void get_selectable_tiles(int* selectable_tiles, int* size, int* current_select_index){
+void get_selectable_tiles(struct game_session* s, int* selectable_tiles, int* size, int* current_select_index){
     int temp_ind = 0;
     int temp_tile_pos;
 
-    // above
-    temp_tile_pos = no_tile_position - TILE_dimension;
-    if (is_tile_position_legal(temp_tile_pos)){
-        selectable_tiles[temp_ind] = temp_tile_pos;
-        if (temp_tile_pos == selected_tile_position){
-            *current_select_index = temp_ind;
-        }
-        temp_ind += 1;
-    } 
-
-    // left
-    temp_tile_pos = no_tile_position - 1;
-    if (is_tile_position_legal(temp_tile_pos) && (temp_tile_pos / TILE_dimension == no_tile_position / TILE_dimension)){
-        selectable_tiles[temp_ind] = temp_tile_pos;
-        if (temp_tile_pos == selected_tile_position){
-            *current_select_index = temp_ind;
-        }
-        temp_ind += 1;
-    } 
-
-    // below
-    temp_tile_pos = no_tile_position + TILE_dimension;
-    if (is_tile_position_legal(temp_tile_pos)){
-        selectable_tiles[temp_ind] = temp_tile_pos;
-        if (temp_tile_pos == selected_tile_position){
-            *current_select_index = temp_ind;
-        }
-        temp_ind += 1;
-    } 
-
-    // right
-    temp_tile_pos = no_tile_position + 1;
-    if (is_tile_position_legal(temp_tile_pos) && (temp_tile_pos / TILE_dimension == no_tile_position / TILE_dimension)){
-        selectable_tiles[temp_ind] = temp_tile_pos;       
-        if (temp_tile_pos == selected_tile_position){
-            *current_select_index = temp_ind;
-        }
-        temp_ind += 1; 
-    } 
+    // above, left, below and right; every tile in the no tile's row and
+    // column can slide, the nearest one in each direction comes first
+    for (int k = 0; k < 4; ++k){
+        temp_tile_pos = s->no_tile_position + move_offset[k];
+        while (is_tile_position_legal(temp_tile_pos) &&
+               (k % 2 == 0 || temp_tile_pos / TILE_dimension == s->no_tile_position / TILE_dimension)){
+            selectable_tiles[temp_ind] = temp_tile_pos;
+            if (temp_tile_pos == s->selected_tile_position){
+                *current_select_index = temp_ind;
+            }
+            temp_ind += 1;
+            temp_tile_pos += move_offset[k];
+        }
+    }
     *size = temp_ind;
 }
 
@@ -641,7 +3069,16 @@ void get_selectable_tiles(int* selectable_tiles, int* size, int* current_select_
 // draw initial configuration of tiles
 void draw_initial_game_tiles(){
    
-   gameNumber = rand()%6;
+   // the nearest bucket that has boards, the harder one first on a tie
+   int pick = -1;
+   for (int d = 0; pick < 0 && d < CORPUS_BUCKETS; ++d){
+       pick = corpus_pick(CORPUS_START_DIFFICULTY + d);
+       if (pick < 0){
+           pick = corpus_pick(CORPUS_START_DIFFICULTY - d);
+       }
+   }
+   // with no corpus at all shuffle() falls back to a random board
+   game->game_number = pick < 0 ? 0 : pick;
     
     shuffle();
 
@@ -655,7 +3092,7 @@ void draw_tile(int position){
     int col = position / 3;
 	
     drawing_png(12 + row*100, 12 + col*75, 
-                        get_png_of_tile(game_tile_positions[TILE_dimension*col + row]),
+                        get_png_of_tile(game->game_tile_positions[TILE_dimension*col + row]),
                         12 + row*100);
 }
 
@@ -663,8 +3100,8 @@ void draw_tile(int position){
 // draw frame around selected tile
 void draw_selected_tile_frame(bool is_erase){
 
-    int row = selected_tile_position % 3;
-    int col = selected_tile_position / 3;
+    int row = game->selected_tile_position % 3;
+    int col = game->selected_tile_position / 3;
 
     int start_pos_x = 12 + row*100;
     int start_pos_y = 12 + col*75;
@@ -777,6 +3214,263 @@ void init_vga_buffer(){
 }
 
 
+// reset the mouse on the second port, it is enabled once it passes its self test
+void config_mouse(){
+    volatile int* PS2_dual_ptr = (int*) PS2_DUAL_BASE;
+
+    *(PS2_dual_ptr) = MOUSE_RESET;
+    *(PS2_dual_ptr + 1) = 1; // set RE to 1 to generate interrupts
+}
+
+
+// ISR for mouse, collects bytes into 3 byte packets
+void mouse_ISR(){
+    volatile int* PS2_dual_ptr = (int*) PS2_DUAL_BASE;
+    int PS2_data = *(PS2_dual_ptr);
+
+    // drain everything the port has buffered
+    while (PS2_data & 0x8000){
+        unsigned char byte = PS2_data & 0xFF;
+        if (byte == MOUSE_SELF_TEST_OK && mouse_byte_index == 0){
+            *(PS2_dual_ptr) = MOUSE_ENABLE;
+        } else if (mouse_byte_index == 0 && (byte == MOUSE_ACK || (byte & 0x08) == 0)){
+            // acks, the id byte after reset and lost sync: bit 3 is always set
+            // in the first byte of a packet
+        } else {
+            mouse_bytes[mouse_byte_index++] = byte;
+            if (mouse_byte_index == 3){
+                mouse_byte_index = 0;
+                mouse_packet(mouse_bytes);
+            }
+        }
+        PS2_data = *(PS2_dual_ptr);
+    }
+}
+
+
+// packet[0] holds the buttons and the sign bits, packet[1] and packet[2] the
+// low 8 bits of the x and y movement; y grows upwards for the mouse
+void mouse_packet(unsigned char packet[]){
+    int dx = packet[1] - ((packet[0] << 4) & 0x100);
+    int dy = packet[2] - ((packet[0] << 3) & 0x100);
+    bool left_down = packet[0] & 0x1;
+
+    if (dx != 0 || dy != 0){
+        int x = cursor_x + dx;
+        int y = cursor_y - dy;
+        x = x < 0 ? 0 : (x > SCREEN_WIDTH - CURSOR_SIZE ? SCREEN_WIDTH - CURSOR_SIZE : x);
+        y = y < 0 ? 0 : (y > SCREEN_HEIGHT - CURSOR_SIZE ? SCREEN_HEIGHT - CURSOR_SIZE : y);
+        if (cursor_visible){
+            cursor_hide();
+            cursor_x = x;
+            cursor_y = y;
+            cursor_show();
+        } else {
+            cursor_x = x;
+            cursor_y = y;
+        }
+    }
+
+    // act on the press, not on the release
+    if (left_down && !mouse_left_down){
+        last_input_ms = system_clock_ms();
+        if (demo_mode){
+            demo_toggle_requested = true;
+        } else if (cursor_visible){
+            cursor_hide();
+            mouse_click(cursor_x, cursor_y);
+            cursor_show();
+        }
+    }
+    mouse_left_down = left_down;
+}
+
+
+void mouse_click(int x, int y){
+    if (game == NULL || game->game_over){
+        return;
+    }
+    // ignore clicks on the gaps between tiles
+    if (x < 12 || y < 12 || (x - 12) % 100 >= 90 || (y - 12) % 75 >= 64){
+        return;
+    }
+    int col = (x - 12) / 100;
+    int row = (y - 12) / 75;
+    if (row >= TILE_dimension || col >= TILE_dimension){
+        return;
+    }
+
+    // only tiles in the no tile's row or column can slide
+    int previous = game->selected_tile_position;
+    game->selected_tile_position = TILE_dimension*row + col;
+    bool can_slide = slide_step(game) != 0;
+    int position = game->selected_tile_position;
+    game->selected_tile_position = previous;
+    if (can_slide){
+        game->keystrokes++;
+        move_tile_at(position);
+    }
+}
+
+
+// clears the flag first, so the mouse ISR stops drawing before pixels are put back
+void cursor_hide(){
+    if (!cursor_visible){
+        return;
+    }
+    cursor_visible = false;
+    for (int y = 0; y < CURSOR_SIZE; ++y){
+        for (int x = 0; x < CURSOR_SIZE; ++x){
+            plot_pixel(cursor_saved_x + x, cursor_saved_y + y, cursor_save_under[y][x]);
+        }
+    }
+}
+
+
+void cursor_show(){
+    if (cursor_visible){
+        return;
+    }
+    cursor_saved_x = cursor_x;
+    cursor_saved_y = cursor_y;
+    for (int y = 0; y < CURSOR_SIZE; ++y){
+        for (int x = 0; x < CURSOR_SIZE; ++x){
+            cursor_save_under[y][x] = read_pixel(cursor_saved_x + x, cursor_saved_y + y);
+            if (cursor_shape[y] & (0x80 >> x)){
+                plot_pixel(cursor_saved_x + x, cursor_saved_y + y, 0);
+            }
+        }
+    }
+    cursor_visible = true;
+}
+
+
+short int read_pixel(int x, int y)
+{
+    return *(short int *)(pixel_buffer_start + (y << 10) + (x << 1));
+}
+
+
+// keys act on release, like the original Enter and arrow handling
+void key_released(int code, bool extended){
+    last_input_ms = system_clock_ms();
+    // keys during startup, the tables can take seconds to build
+    if (game == NULL){
+        return;
+    }
+    if (demo_mode){
+        demo_toggle_requested = true;
+        return;
+    }
+    if (rebind_stage != 0){
+        keymap_rebind(code, extended);
+        return;
+    }
+
+    int index = keymap_lookup(code, extended);
+    if (index < 0){
+        return;
+    }
+    int action = keymap[index].action;
+    // counted up front so a winning key is in the count printed on the win,
+    // and taken back below if the key changed neither the board nor the selection
+    unsigned long long board = board_key(game->game_tile_positions);
+    int selected = game->selected_tile_position;
+    game->keystrokes++;
+    // keep the cursor out of the way of actions that redraw tiles; it is only
+    // put back if it was up, the main loop hides it while it draws
+    bool draws = action != ACTION_DEMO && action != ACTION_REBIND && action != ACTION_PROFILE_DUMP;
+    bool cursor_was_visible = cursor_visible;
+    if (draws){
+        cursor_hide();
+    }
+    switch (action){
+    case ACTION_SLIDE_UP:
+    case ACTION_SLIDE_LEFT:
+    case ACTION_SLIDE_DOWN:
+    case ACTION_SLIDE_RIGHT:
+        slide_tile(action);
+        break;
+    case ACTION_SELECT_NEXT:
+        select_new_selected_tile(-1);
+        break;
+    case ACTION_SELECT_PREV:
+        select_new_selected_tile(1);
+        break;
+    case ACTION_MOVE:
+        swap_tile();
+        break;
+    case ACTION_SHUFFLE:
+        shuffle();
+        break;
+    case ACTION_HINT:
+        show_hint();
+        break;
+    case ACTION_DEMO:
+        demo_toggle_requested = true;
+        break;
+    case ACTION_UNDO:
+        undo_tile();
+        break;
+    case ACTION_REDO:
+        redo_tile();
+        break;
+    case ACTION_REWIND:
+        rewind_board();
+        break;
+    case ACTION_REBIND:
+        rebind_stage = 1;
+        break;
+    case ACTION_NEXT_MODE:
+        next_game_mode();
+        break;
+#if PROFILE_ENABLED
+    case ACTION_PROFILE_DUMP:
+        profile_dump_requested = true;
+        break;
+#endif
+    }
+    if (draws && cursor_was_visible){
+        cursor_show();
+    }
+    // a new game from shuffle() starts at 0 and keeps it
+    if (board_key(game->game_tile_positions) == board && game->selected_tile_position == selected &&
+        game->keystrokes > 0){
+        game->keystrokes--;
+    }
+}
+
+
+int keymap_lookup(int code, bool extended){
+    for (int i = 0; i < keymap_size; ++i){
+        if (keymap[i].code == code && keymap[i].extended == extended){
+            return i;
+        }
+    }
+    return -1;
+}
+
+
+// the new key is swapped with the old one, so a key taken from another
+// binding leaves that action on the old key instead of unbinding it
+void keymap_rebind(int code, bool extended){
+    int index = keymap_lookup(code, extended);
+    if (rebind_stage == 1){
+        // an unbound key cancels
+        rebind_index = index;
+        rebind_stage = index < 0 ? 0 : 2;
+        return;
+    }
+    if (index >= 0){
+        keymap[index].code = keymap[rebind_index].code;
+        keymap[index].extended = keymap[rebind_index].extended;
+    }
+    keymap[rebind_index].code = code;
+    keymap[rebind_index].extended = extended;
+    rebind_stage = 0;
+}
+
+
 // configure PS2 to reset & generate interrupts
 void config_PS2(){
     volatile int* PS2_ptr = (int*) PS2_BASE;
@@ -841,6 +3535,109 @@ void display_on_hex(int num_a, int num_b, int num_c, int num_d, int num_e, int n
 
 }
 
+#if PROFILE_ENABLED
+// start the A9 private timer free running from 0xFFFFFFFF with auto reload,
+// so the difference of two reads is the elapsed cycles even across a wrap
+void config_private_timer(){
+    volatile int* private_timer_ptr = (int *) MPCORE_PRIV_TIMER;
+
+    *(private_timer_ptr) = 0xFFFFFFFF; // load
+    *(private_timer_ptr + 2) = 0x3; // prescaler = 0, I = 0, A = 1, E = 1
+}
+
+
+unsigned int read_cycle_counter(){
+    return *((volatile unsigned int *)(MPCORE_PRIV_TIMER + 0x4));
+}
+
+
+// the demo plays moves from the main loop, so IRQs are masked around the push
+// to keep an ISR producer from racing it on profile_head
+void profile_record(int probe, unsigned int cycles){
+    int status;
+    asm("mrs %[ps], cpsr" : [ps] "=r"(status));
+    asm("msr cpsr_c, %[ps]" : : [ps] "r"(status | 0x80));
+    if (profile_head - profile_tail >= PROFILE_RING_SIZE){
+        profile_dropped++;
+    } else {
+        // top 2 bits hold the probe id, cycles saturate at 2^30
+        if (cycles > 0x3FFFFFFF){
+            cycles = 0x3FFFFFFF;
+        }
+        profile_ring[profile_head & (PROFILE_RING_SIZE - 1)] = (probe << 30) | cycles;
+        profile_head++;
+    }
+    asm("msr cpsr_c, %[ps]" : : [ps] "r"(status));
+}
+
+
+void profile_drain(){
+    while (profile_tail != profile_head){
+        unsigned int sample = profile_ring[profile_tail & (PROFILE_RING_SIZE - 1)];
+        int probe = sample >> 30;
+        unsigned int cycles = sample & 0x3FFFFFFF;
+
+        profile_histogram[probe][profile_bucket(cycles)]++;
+        if (cycles > profile_max[probe]){
+            profile_max[probe] = cycles;
+        }
+        profile_tail++;
+    }
+}
+
+
+// log-linear bucket: power of 2 plus the next 2 bits, so at most 25% error
+int profile_bucket(unsigned int cycles){
+    if (cycles < 4){
+        return cycles;
+    }
+    int msb = 31 - __builtin_clz(cycles);
+    return (msb - 1)*4 + ((cycles >> (msb - 2)) & 0x3);
+}
+
+
+// lowest cycle count that falls into the bucket
+unsigned int profile_bucket_value(int bucket){
+    if (bucket < 4){
+        return bucket;
+    }
+    int msb = bucket/4 + 1;
+    return (unsigned int)(4 + bucket % 4) << (msb - 2);
+}
+
+
+void profile_dump(){
+    char* names[] = {"PS2_ISR", "timer_ISR", "swap_tile", "frame"};
+    int percentiles[] = {50, 90, 99};
+
+    profile_drain();
+    printf("probe       count      p50      p90      p99      max (cycles @ 200MHz)\n");
+    for (int probe = 0; probe < PROF_NUM_PROBES; ++probe){
+        unsigned int total = 0;
+        for (int b = 0; b < PROFILE_BUCKETS; ++b){
+            total += profile_histogram[probe][b];
+        }
+        printf("%-10s %6u", names[probe], total);
+
+        for (int p = 0; p < 3; ++p){
+            unsigned int target = (total*percentiles[p] + 99)/100;
+            unsigned int seen = 0;
+            int b = 0;
+            for (; b < PROFILE_BUCKETS - 1; ++b){
+                seen += profile_histogram[probe][b];
+                if (seen >= target){
+                    break;
+                }
+            }
+            printf(" %8u", total ? profile_bucket_value(b) : 0);
+        }
+        printf(" %8u\n", profile_max[probe]);
+    }
+    printf("dropped samples: %u\n", profile_dropped);
+}
+#endif
+
+
 int* get_png_of_tile(int num){
     static int display_1[]= {
     0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x20, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x20, 0x00, 0x21, 0x08, 
@@ -1406,7 +4203,7 @@ int* get_png_of_tile(int num){
 }
 
 
-win[]={	
+int win[]={	
 	 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 
   0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 
   0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 
@@ -1568,7 +4365,7 @@ win[]={
   0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 
   0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 
 };
-lose[]={
+int lose[]={
 	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 
   0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 
   0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 
@@ -0,0 +1,816 @@
+// host tests for 15-puzzle-game.c, the game logic runs unchanged on a PC.
+// The MMIO page at 0xFF200000 is mapped as plain memory, so the interval
+// timer registers are written by the test to fake the time, and the inline
+// assembly (IRQ masking, stacks) is compiled out.
+//
+//     gcc -O2 -Wall -o host_test tests/host_test.c && ./host_test
+//
+// Optional features are tested by setting their *_ENABLED #define in the
+// game to 1 and rebuilding. Exits with the number of failed checks.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+#include <stdarg.h>
+#include <sys/mman.h>
+
+#define asm(...)
+#define interrupt
+#define main game_main
+// with the assembly compiled out the PSR values it took are unused, and the
+// 32 bit register addresses are cast to 64 bit pointers
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-variable"
+#pragma GCC diagnostic ignored "-Wunused-but-set-variable"
+#pragma GCC diagnostic ignored "-Wint-to-pointer-cast"
+#include "../15-puzzle-game.c"
+#pragma GCC diagnostic pop
+#undef main
+
+#define MMIO_BASE             0xFF200000    // lightweight bridge devices, timer at TIMER_BASE
+#define MMIO_SPAN             0x10000
+#define FRAME_BASE            0x20000000    // host pixel buffer, below 2^31 so pixel_buffer_start holds it
+#define FRAME_SPAN            0x40000       // 240 rows of 1024 bytes
+#define RANDOM_BOARDS         500           // boards solved against the hint table
+#define RANDOM_MOVES          200           // slides per history walk, under HISTORY_MAX_MOVES tiles
+
+int failures = 0;
+int checks = 0;
+
+// counts every heap allocation, the solver must not make any
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t count, size_t size);
+extern void* __libc_realloc(void* pointer, size_t size);
+int allocations = 0;
+
+void* malloc(size_t size){
+    allocations++;
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size){
+    allocations++;
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* pointer, size_t size){
+    allocations++;
+    return __libc_realloc(pointer, size);
+}
+
+struct score_store host_score_store;
+
+#define CHECK(condition, ...) check(condition, __FILE__, __LINE__, __VA_ARGS__)
+
+void check(bool condition, const char* file, int line, const char* format, ...);
+void set_timer(unsigned int periods, unsigned int remaining, bool timeout_pending);
+void solvable_board(int board[]); // random_board() repaired if needed
+void random_slide(struct game_session* s);
+void test_clock();
+void test_limits();
+void test_stats();
+void test_history();
+void test_solver();
+void test_hints();
+void test_corpus();
+void test_leaderboard();
+void test_rank_round_trip(int k); // every rank of k values out of the cells
+void test_ranks();
+int ida_trace(int board[], int bounds[], unsigned long long nodes[]); // iterations of one IDA* solve
+void test_validate();
+void mouse_move(int dx, int dy, bool left_down); // one packet, dy grows upwards as for the mouse
+void cursor_to(int x, int y, bool left_down); // into the top left corner, then across in packets
+void test_mouse();
+void test_child_order();
+#if PDB_ENABLED
+int pattern_manhattan(int pattern[]);
+void test_pdb_unbuilt(); // before pdb_init()
+void test_pdb();
+#endif
+
+
+void check(bool condition, const char* file, int line, const char* format, ...){
+    checks++;
+    if (condition){
+        return;
+    }
+    failures++;
+    va_list args;
+    va_start(args, format);
+    printf("%s:%d: ", file, line);
+    vprintf(format, args);
+    printf("\n");
+    va_end(args);
+}
+
+
+// the timer counts down from TIMER_PERIOD - 1, snaph holds the upper half;
+// the latch write in system_clock_ms() clears snapl, so remaining is rounded
+// down to a multiple of 0x10000 cycles (under 1 ms)
+void set_timer(unsigned int periods, unsigned int remaining, bool timeout_pending){
+    volatile int* interval_timer_ptr = (int *)TIMER_BASE;
+    clock_periods = periods;
+    *(interval_timer_ptr) = timeout_pending ? 1 : 0;
+    *(interval_timer_ptr + 0x5) = remaining >> 16;
+}
+
+
+// simulated clock: each reading is checked against the time the registers
+// stand for, including a timeout the ISR has not counted yet because IRQs
+// were masked
+void test_clock(){
+    unsigned int cycles = TIMER_PERIOD - 1;
+    for (unsigned int periods = 0; periods < 5; ++periods){
+        for (unsigned int step = 0; step <= 10; ++step){
+            unsigned int remaining = (cycles - step*(cycles/10)) & ~0xFFFFu;
+            set_timer(periods, remaining, false);
+            unsigned int expected = periods*TIMER_MS_PER_PERIOD + (cycles - remaining)/TIMER_CYCLES_PER_MS;
+            unsigned int ms = system_clock_ms();
+            CHECK(ms == expected, "clock %u ms, expected %u", ms, expected);
+        }
+    }
+
+    // just before a timeout, then the counter reloaded while the IRQ is held
+    // off for up to almost a whole period: time must keep going forwards
+    set_timer(7, 0, false);
+    unsigned int before = system_clock_ms();
+    unsigned int last = before;
+    for (unsigned int delay_ms = 0; delay_ms < TIMER_MS_PER_PERIOD; delay_ms += 37){
+        unsigned int remaining = (cycles - delay_ms*TIMER_CYCLES_PER_MS) & ~0xFFFFu;
+        set_timer(7, remaining, true);
+        unsigned int ms = system_clock_ms();
+        CHECK(ms >= last, "clock went back from %u to %u ms with the IRQ delayed %u ms", last, ms, delay_ms);
+        CHECK(ms - before <= delay_ms + 1, "clock jumped %u ms with the IRQ delayed %u ms", ms - before, delay_ms);
+        last = ms;
+
+        // the ISR finally runs, which must not change the reading
+        interval_timer_ISR();
+        *(int *)(TIMER_BASE + 0x14) = remaining >> 16;
+        unsigned int after_isr = system_clock_ms();
+        CHECK(after_isr == ms, "clock %u ms after the ISR, %u ms before", after_isr, ms);
+    }
+
+    // the game clock stops with the game
+    struct game_session* s = session_alloc();
+    set_timer(20, cycles, false);
+    game_clock_reset(s);
+    set_timer(23, cycles/2 & ~0xFFFFu, false);
+    unsigned int played = game_clock_ms(s);
+    CHECK(played >= 3499 && played <= 3500, "played %u ms, expected 3500", played);
+    game_clock_pause(s);
+    s->game_over = true;
+    set_timer(40, cycles, false);
+    CHECK(game_clock_ms(s) == played, "game clock moved to %u ms after the game ended at %u ms", game_clock_ms(s), played);
+    session_free(s);
+}
+
+
+void solvable_board(int board[]){
+    random_board(board);
+    if (board_validate(board) == BOARD_UNSOLVABLE){
+        board_repair(board);
+    }
+}
+
+
+// the flag counter() waits on: set by the timer ISR at the first tick past
+// the deadline and by the move that uses up the limit, never for a solved board
+void test_limits(){
+    struct game_mode saved = mode;
+    int board[] = {8, 7, 6, 5, 4, 3, 2, 1, NO_TILE};
+    game = session_alloc();
+    new_game_board(game, board);
+
+    mode.time_limit_ms = 3000;
+    mode.move_limit = NO_LIMIT;
+    set_timer(20, (TIMER_PERIOD - 1)/2 & ~0xFFFFu, false);
+    game_clock_reset(game);
+    for (unsigned int periods = 20; periods < 23; ++periods){
+        set_timer(periods, 0, true);
+        interval_timer_ISR();
+        CHECK(!session_limit_reached(game), "out of time at %u s, the limit is 3 s from 20.5 s", clock_periods);
+    }
+    set_timer(23, 0, true);
+    interval_timer_ISR();
+    CHECK(session_limit_reached(game), "not out of time at the tick at %u s", clock_periods);
+
+    game_clock_reset(game);
+    game->game_over = true;
+    set_timer(40, 0, true);
+    interval_timer_ISR();
+    CHECK(!game->limit_reached, "the timer ISR ran out the clock of a solved game");
+    game->game_over = false;
+
+    mode.time_limit_ms = NO_LIMIT;
+    mode.move_limit = 2;
+    game_clock_reset(game);
+    set_timer(100, 0, true);
+    interval_timer_ISR();
+    random_slide(game);
+    CHECK(!session_limit_reached(game), "out of moves after 1 of 2");
+    random_slide(game);
+    CHECK(session_limit_reached(game), "not out of moves after 2 of 2");
+
+    // the move that solves the board is not also the one that ran out
+    int slid[] = {1, 2, 3, 4, 5, 6, NO_TILE, 7, 8};
+    game = session_recycle(game);
+    new_game_board(game, slid);
+    mode.move_limit = 1;
+    game_clock_reset(game);
+    game->selected_tile_position = TILE_dimension*TILE_dimension - 1;
+    session_move(game);
+    CHECK(game->game_over && !game->limit_reached, "the solving move ran out of moves");
+
+    session_free(game);
+    game = NULL;
+    mode = saved;
+}
+
+
+// selects a tile in the row or column of the no tile and slides it
+void random_slide(struct game_session* s){
+    int row = s->no_tile_position / TILE_dimension;
+    int col = s->no_tile_position % TILE_dimension;
+    int other = rand() % (TILE_dimension - 1);
+    if (rand() % 2){
+        col = other < col ? other : other + 1;
+    }
+    else {
+        row = other < row ? other : other + 1;
+    }
+    s->selected_tile_position = row*TILE_dimension + col;
+    session_move(s);
+}
+
+
+// incremental statistics against a full recompute after every slide
+void test_stats(){
+    struct game_session* s = session_alloc();
+    static struct game_session full;
+    int board[TILE_dimension*TILE_dimension];
+    for (int game_index = 0; game_index < 100; ++game_index){
+        solvable_board(board);
+        new_game_board(s, board);
+        s->game_over = false;
+        for (int slide = 0; slide < RANDOM_MOVES && !s->game_over; ++slide){
+            random_slide(s);
+            full = *s;
+            board_stats_recompute(&full);
+            bool same = s->misplaced_tiles == full.misplaced_tiles &&
+                        s->manhattan_distance == full.manhattan_distance &&
+                        s->linear_conflicts == full.linear_conflicts &&
+                        s->inversions == full.inversions;
+            for (int line = 0; line < TILE_dimension; ++line){
+                same = same && s->row_conflicts[line] == full.row_conflicts[line] &&
+                               s->col_conflicts[line] == full.col_conflicts[line];
+            }
+            CHECK(same, "stats of board %llx differ from a recompute", board_key(s->game_tile_positions));
+        }
+    }
+    session_free(s);
+}
+
+
+// undo back to the shuffled board, redo to the end, then restore at random
+// points, the board must match the one seen at each position
+void test_history(){
+    struct game_session* s = session_alloc();
+    static unsigned long long keys[HISTORY_MAX_MOVES + 1]; // board after each tile move
+    static int slide_ends[HISTORY_MAX_MOVES + 1]; // history_position after each slide
+    int board[TILE_dimension*TILE_dimension];
+    for (int game_index = 0; game_index < 50; ++game_index){
+        solvable_board(board);
+        new_game_board(s, board);
+        s->game_over = false;
+        keys[0] = board_key(s->game_tile_positions);
+        slide_ends[0] = 0;
+        int slides = 0;
+        for (int slide = 0; slide < RANDOM_MOVES && !s->game_over; ++slide){
+            int position = s->history_position;
+            int replay[TILE_dimension*TILE_dimension];
+            memcpy(replay, s->game_tile_positions, sizeof(replay));
+            int blank = s->no_tile_position;
+            random_slide(s);
+            if (s->game_over){
+                break; // a solved game refuses undo and restore
+            }
+            // the run is recorded one tile at a time, replay it to know the
+            // board at each of those positions
+            // the no tile ends up where the selected tile was
+            int target = s->no_tile_position;
+            int step = target / TILE_dimension == blank / TILE_dimension ? 1 : TILE_dimension;
+            if (target < blank){
+                step = -step;
+            }
+            for (int index = position; index < s->history_position; ++index){
+                replay[blank] = replay[blank + step];
+                replay[blank + step] = NO_TILE;
+                blank += step;
+                keys[index + 1] = board_key(replay);
+            }
+            slide_ends[++slides] = s->history_position;
+        }
+        if (s->game_over){
+            continue;
+        }
+        CHECK(keys[s->history_position] == board_key(s->game_tile_positions), "replayed history does not end on the board");
+
+        // undo and redo take back and play again a whole slide at a time
+        int length = s->history_length;
+        int slide = slides;
+        while (session_undo(s)){
+            slide--;
+            CHECK(slide >= 0 && s->history_position == slide_ends[slide] &&
+                  board_key(s->game_tile_positions) == keys[s->history_position],
+                  "undo %d of %d stopped at tile move %d", slides - slide, slides, s->history_position);
+        }
+        CHECK(slide == 0 && s->history_position == 0, "undo stopped at tile move %d", s->history_position);
+        while (session_redo(s)){
+            slide++;
+            CHECK(slide <= slides && s->history_position == slide_ends[slide] &&
+                  board_key(s->game_tile_positions) == keys[s->history_position],
+                  "redo %d of %d stopped at tile move %d", slide, slides, s->history_position);
+        }
+        CHECK(s->history_position == length, "redo stopped at tile move %d of %d", s->history_position, length);
+        for (int i = 0; i < 20 && !s->game_over; ++i){
+            int position = rand() % (length + 1);
+            session_restore(s, position);
+            CHECK(s->history_position == position && board_key(s->game_tile_positions) == keys[position],
+                  "restore to move %d gave a different board", position);
+            CHECK(s->game_tile_positions[s->no_tile_position] == NO_TILE, "restore lost the no tile");
+        }
+    }
+    session_free(s);
+}
+
+
+// optimal lengths against the exact table, with no heap allocation on the way
+void test_solver(){
+    struct solver* solver = solver_create();
+    int board[TILE_dimension*TILE_dimension];
+    for (int i = 0; i < RANDOM_BOARDS; ++i){
+        solvable_board(board);
+        allocations = 0;
+        int length = solver_solve(solver, board);
+        CHECK(allocations == 0, "solving %llx allocated %d times", board_key(board), allocations);
+#if HINT_TABLE_ENABLED
+        int exact = hint_table_distance(board);
+        CHECK(length == exact, "solved %llx in %d moves, the hint table says %d", board_key(board), length, exact);
+#endif
+
+        // following the path must reach the goal in that many moves
+        int moves = 0;
+        int position;
+        while ((position = solver_next_move(solver, board)) != NO_TILE){
+            int blank = 0;
+            while (board[blank] != NO_TILE){
+                blank++;
+            }
+            board[blank] = board[position];
+            board[position] = NO_TILE;
+            moves++;
+        }
+        CHECK(moves == length, "path of %d moves, solve said %d", moves, length);
+        int misplaced = 0;
+        for (int cell = 0; cell + 1 < TILE_dimension*TILE_dimension; ++cell){
+            misplaced += board[cell] != cell + 1;
+        }
+        CHECK(misplaced == 0, "path did not reach the goal");
+    }
+    solver_destroy(solver);
+}
+
+
+// hints before the hint table is ready come from hint_solver; taking each
+// one reaches the goal in the moves a fresh solve needs
+void test_hints(){
+    bool table_ready = hint_table_ready;
+    hint_table_ready = false;
+    struct solver* solver = solver_create();
+    struct game_session* s = session_alloc();
+    int board[TILE_dimension*TILE_dimension];
+    for (int i = 0; i < RANDOM_BOARDS/10; ++i){
+        solvable_board(board);
+        new_game_board(s, board);
+        int length = solver_solve(solver, board);
+        int moves = 0;
+        int position;
+        allocations = 0;
+        while ((position = get_hint(s)) != NO_TILE && moves <= length){
+            s->selected_tile_position = position;
+            CHECK(session_move(s), "hint %d on %llx could not be moved", position, board_key(s->game_tile_positions));
+            moves++;
+        }
+        CHECK(allocations == 0, "hints for %llx allocated %d times", board_key(board), allocations);
+        CHECK(s->misplaced_tiles == 0, "hints for %llx did not reach the goal in %d moves", board_key(board), moves);
+#if SOLVER_WEIGHT == 10
+        CHECK(moves == length, "hints for %llx took %d moves, solve said %d", board_key(board), moves, length);
+#endif
+        s = session_recycle(s);
+    }
+    session_free(s);
+    solver_destroy(solver);
+    hint_table_ready = table_ready;
+}
+
+
+void test_corpus(){
+    struct solver* solver = solver_create();
+    int board[TILE_dimension*TILE_dimension];
+    CHECK(corpus_open(&builtin_corpus.header), "builtin corpus did not open");
+    for (int i = 0; i < corpus_count; ++i){
+        corpus_board(i, board);
+        allocations = 0;
+        int length = solver_solve(solver, board);
+        CHECK(allocations == 0, "corpus board %d allocated %d times", i, allocations);
+        CHECK(length == corpus_records[i].optimal_moves, "corpus board %d solved in %d moves, recorded as %d",
+              i, length, corpus_records[i].optimal_moves);
+    }
+    solver_destroy(solver);
+}
+
+
+// the top lists rebuilt from the log after a reset match the ones kept live
+void test_leaderboard(){
+    static unsigned int live[LEADERBOARD_BOARDS][LEADERBOARD_TOP];
+    static int live_count[LEADERBOARD_BOARDS];
+    struct score_record* scores[LEADERBOARD_TOP];
+    score_store = &host_score_store;
+    memset(&host_score_store, 0, sizeof(host_score_store));
+    leaderboard_load();
+    for (int i = 0; i < 1000; ++i){
+        leaderboard_append(rand() % LEADERBOARD_BOARDS, 10 + rand() % 40, rand() % 60000, rand() % 1024);
+    }
+    for (int board = 0; board < LEADERBOARD_BOARDS; ++board){
+        live_count[board] = leaderboard_top(board, scores, LEADERBOARD_TOP);
+        for (int i = 0; i < live_count[board]; ++i){
+            live[board][i] = scores[i]->moves << 20 ^ scores[i]->elapsed_ms;
+        }
+    }
+    leaderboard_load();
+    for (int board = 0; board < LEADERBOARD_BOARDS; ++board){
+        int count = leaderboard_top(board, scores, LEADERBOARD_TOP);
+        bool same = count == live_count[board];
+        for (int i = 0; same && i < count; ++i){
+            same = live[board][i] == (scores[i]->moves << 20 ^ scores[i]->elapsed_ms);
+        }
+        CHECK(same, "top list of board %d changed after a reload", board);
+    }
+}
+
+
+// unrank then rank gives the rank back, and consecutive ranks unrank to
+// permutations in increasing lexicographic order, so ranking is a bijection
+// onto 0..n!/(n-k)!-1
+void test_rank_round_trip(int k){
+    int cells = TILE_dimension*TILE_dimension;
+    unsigned long long count = 1;
+    for (int i = 0; i < k; ++i){
+        count *= cells - i;
+    }
+    int values[TILE_dimension*TILE_dimension];
+    int previous[TILE_dimension*TILE_dimension];
+    int errors = 0;
+    // every rank up to 3x3 boards, evenly spaced ones above
+    unsigned long long stride = count > (1 << 22) ? count >> 22 : 1;
+    for (unsigned long long rank = 0; rank < count; rank += stride){
+        permutation_unrank(rank, values, k);
+        unsigned int used = 0;
+        for (int i = 0; i < k; ++i){
+            used |= 1u << values[i];
+        }
+        bool ordered = true;
+        if (rank > 0){
+            int i = 0;
+            while (i < k && values[i] == previous[i]){
+                i++;
+            }
+            ordered = i < k && values[i] > previous[i];
+        }
+        if (permutation_rank(values, k) != rank || __builtin_popcount(used) != k || !ordered){
+            errors++;
+        }
+        memcpy(previous, values, k*sizeof(int));
+    }
+    CHECK(errors == 0, "%d of %llu ranks of %d values failed the round trip", errors, count, k);
+}
+
+
+void test_ranks(){
+    test_rank_round_trip(TILE_dimension*TILE_dimension);
+    test_rank_round_trip(6); // the pattern database's no tile and 5 tiles
+    test_rank_round_trip(1);
+
+    int board[TILE_dimension*TILE_dimension];
+    int unranked[TILE_dimension*TILE_dimension];
+    for (int i = 0; i < RANDOM_BOARDS; ++i){
+        random_board(board);
+        board_unrank(board_rank(board), unranked);
+        CHECK(memcmp(board, unranked, sizeof(board)) == 0, "board %llx did not survive board_rank()", board_key(board));
+    }
+}
+
+
+void mouse_move(int dx, int dy, bool left_down){
+    unsigned char packet[3];
+    packet[0] = 0x08 | (left_down ? 0x1 : 0) | (dx < 0 ? 0x10 : 0) | (dy < 0 ? 0x20 : 0);
+    packet[1] = dx & 0xFF;
+    packet[2] = dy & 0xFF;
+    mouse_packet(packet);
+}
+
+
+void cursor_to(int x, int y, bool left_down){
+    mouse_move(-255, 255, left_down);
+    mouse_move(-255, 255, left_down);
+    while (cursor_x < x || cursor_y < y){
+        int dx = x - cursor_x > 255 ? 255 : x - cursor_x;
+        int dy = y - cursor_y > 255 ? 255 : y - cursor_y;
+        mouse_move(dx, -dy, left_down);
+    }
+}
+
+
+// packets as the mouse sends them: 9 bit movement with the sign in byte 0,
+// the cursor kept on screen, a click on the press only, and the tile under
+// the cursor sliding with the run between it and the no tile
+void test_mouse(){
+    void* frame = mmap((void*) FRAME_BASE, FRAME_SPAN, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+    if (frame == MAP_FAILED){
+        CHECK(false, "no host pixel buffer at 0x%x", FRAME_BASE);
+        return;
+    }
+    volatile int* pixel_ctrl_ptr = (int *)0xFF203020;
+    *(pixel_ctrl_ptr) = FRAME_BASE;
+    *(pixel_ctrl_ptr + 1) = FRAME_BASE; // the back buffer animate_swap_tile() swaps to
+    pixel_buffer_start = FRAME_BASE;
+
+    game = session_alloc();
+    int board[TILE_dimension*TILE_dimension];
+    for (int i = 0; i < TILE_dimension*TILE_dimension; ++i){
+        board[i] = i + 1 < TILE_dimension*TILE_dimension ? i + 1 : NO_TILE;
+    }
+    new_game_board(game, board);
+    game->game_over = false;
+    session_reset_selection(game);
+
+    // the save-under puts back what the cursor covered
+    static short int before[FRAME_SPAN/2];
+    memcpy(before, frame, FRAME_SPAN);
+    cursor_x = 100;
+    cursor_y = 100;
+    cursor_show();
+    mouse_move(-10, 5, false);
+    CHECK(cursor_x == 90 && cursor_y == 95, "cursor at %d,%d after -10,+5, expected 90,95", cursor_x, cursor_y);
+    mouse_move(-200, -100, false); // 9 bit two's complement
+    CHECK(cursor_x == 0 && cursor_y == 195, "cursor at %d,%d after -200,-100, expected 0,195", cursor_x, cursor_y);
+    mouse_move(255, -255, false);
+    mouse_move(255, 0, false);
+    CHECK(cursor_x == SCREEN_WIDTH - CURSOR_SIZE && cursor_y == SCREEN_HEIGHT - CURSOR_SIZE,
+          "cursor at %d,%d not clamped to the screen", cursor_x, cursor_y);
+    mouse_move(-255, 255, false);
+    mouse_move(-255, 255, false);
+    CHECK(cursor_x == 0 && cursor_y == 0, "cursor at %d,%d not clamped to 0,0", cursor_x, cursor_y);
+    cursor_hide();
+    CHECK(memcmp(before, frame, FRAME_SPAN) == 0, "cursor left pixels behind");
+    cursor_show();
+
+    // a click on a gap or on a tile out of the no tile's lines does nothing
+    cursor_to(12 + 95, 12 + 30, false);
+    mouse_move(0, 0, true);
+    mouse_move(0, 0, false);
+    cursor_to(12 + 45, 12 + 30, false);
+    mouse_move(0, 0, true);
+    mouse_move(0, 0, false);
+    CHECK(board_key(game->game_tile_positions) == board_key(board) && game->moves == 0, "a click that cannot slide moved a tile");
+
+    // bottom left tile: both tiles of the bottom row slide right
+    cursor_to(12 + 45, 12 + 2*75 + 30, false);
+    mouse_move(0, 0, true);
+    int slid[] = {1, 2, 3, 4, 5, 6, NO_TILE, 7, 8};
+    CHECK(board_key(game->game_tile_positions) == board_key(slid) && game->moves == 1,
+          "click on the bottom left tile gave %llx after %d moves", board_key(game->game_tile_positions), game->moves);
+
+    // holding the button is not another click, even when the mouse moves
+    cursor_to(12 + 45, 12 + 30, true);
+    mouse_move(0, 0, true);
+    CHECK(board_key(game->game_tile_positions) == board_key(slid) && game->moves == 1, "a held button clicked again");
+    mouse_move(0, 0, false);
+    mouse_move(0, 0, true);
+    int column[] = {NO_TILE, 2, 3, 1, 5, 6, 4, 7, 8};
+    CHECK(board_key(game->game_tile_positions) == board_key(column) && game->moves == 2,
+          "a new press on the top left tile gave %llx", board_key(game->game_tile_positions));
+    mouse_move(0, 0, false);
+
+    cursor_hide();
+    session_free(game);
+    game = NULL;
+    munmap(frame, FRAME_SPAN);
+}
+
+
+// boards_validate() over a mix of valid, unsolvable and malformed boards
+// counts exactly the boards board_validate() passes one at a time
+void test_validate(){
+    enum { BOARDS = 4096, CELLS = TILE_dimension*TILE_dimension };
+    static int boards[BOARDS*CELLS];
+    int statuses[3] = {0, 0, 0};
+    int valid = 0;
+    for (int i = 0; i < BOARDS; ++i){
+        int* board = &boards[i*CELLS];
+        random_board(board);
+        int cell = rand() % CELLS;
+        switch (rand() % 6){
+            case 0: board[cell] = 0; break; // the usual slip for the no tile
+            case 1: board[cell] = board[(cell + 1) % CELLS]; break; // duplicate
+            case 2: board[cell] = CELLS + rand() % 4; break; // out of range
+            case 3: board[cell] = -2 - rand() % 4; break; // negative, not NO_TILE
+            default: break; // a permutation, solvable or not
+        }
+        int status = board_validate(board);
+        statuses[status]++;
+        if (status == BOARD_VALID){
+            valid++;
+        }
+        if ((i + 1) % 512 == 0){
+            CHECK(boards_validate(boards, i + 1) == valid, "boards_validate() of %d boards is %d, one at a time %d",
+                  i + 1, boards_validate(boards, i + 1), valid);
+        }
+    }
+    CHECK(statuses[BOARD_VALID] > 0 && statuses[BOARD_UNSOLVABLE] > 0 && statuses[BOARD_MALFORMED] > 0,
+          "board mix has %d valid, %d unsolvable and %d malformed boards", statuses[0], statuses[1], statuses[2]);
+
+    // each kind of malformed board on its own
+    int board[CELLS];
+    random_board(board);
+    board[rand() % CELLS] = 0;
+    CHECK(board_validate(board) == BOARD_MALFORMED, "a 0 tile was not rejected");
+    random_board(board);
+    board[0] = board[1];
+    CHECK(board_validate(board) == BOARD_MALFORMED, "a duplicate tile was not rejected");
+    random_board(board);
+    board[CELLS - 1] = CELLS;
+    CHECK(board_validate(board) == BOARD_MALFORMED, "tile %d was not rejected", CELLS);
+}
+
+
+// solve_board() without the bidirectional search, recording the bound each
+// iteration returned and the nodes it visited
+int ida_trace(int board[], int bounds[], unsigned long long nodes[]){
+    int no_tile_position = 0;
+    int manhattan_distance = 0;
+    for (int i = 0; i < TILE_dimension*TILE_dimension; ++i){
+        hint_board[i] = board[i];
+        if (board[i] == NO_TILE){
+            no_tile_position = i;
+        } else {
+            manhattan_distance += tile_distance(board[i], i);
+        }
+    }
+    hint_key = board_key(hint_board);
+    int bound = SOLVER_WEIGHT*manhattan_distance;
+#if PDB_ENABLED
+    pdb_pattern(hint_board, hint_pattern);
+    hint_pdb = pdb_distance(hint_pattern);
+    if (hint_pdb > manhattan_distance){
+        bound = SOLVER_WEIGHT*hint_pdb;
+    }
+#endif
+    int iterations = 0;
+    while (bound != HINT_FOUND){
+#if TT_ENABLED
+        tt_iteration++;
+#endif
+        solver_nodes = 0;
+        bound = hint_search(no_tile_position, NO_TILE, 0, bound, manhattan_distance);
+        bounds[iterations] = bound;
+        nodes[iterations++] = solver_nodes;
+    }
+    return iterations;
+}
+
+
+// the distance table is tile_distance() exactly, and searching the children
+// closest first only changes the work of the last iteration: every earlier
+// one visits the whole tree under its bound. The transposition table keeps
+// the first visit of a state, so with it only the bounds must match
+void test_child_order(){
+    for (int tile = 1; tile < TILE_dimension*TILE_dimension; ++tile){
+        for (int position = 0; position < TILE_dimension*TILE_dimension; ++position){
+            CHECK(distance_table[tile][position] == tile_distance(tile, position),
+                  "distance_table[%d][%d] is %d, tile_distance() %d", tile, position,
+                  distance_table[tile][position], tile_distance(tile, position));
+        }
+    }
+
+    int board[TILE_dimension*TILE_dimension];
+    int bounds[2][SOLUTION_MAX_MOVES];
+    unsigned long long nodes[2][SOLUTION_MAX_MOVES];
+    int iterations[2];
+    int length[2];
+    srand(BENCHMARK_SEED);
+    for (int i = 0; i < BENCHMARK_BOARDS; ++i){
+        solvable_board(board);
+        for (int ordered = 0; ordered < 2; ++ordered){
+            hint_ordered = ordered;
+            iterations[ordered] = ida_trace(board, bounds[ordered], nodes[ordered]);
+            length[ordered] = solution_length;
+        }
+        bool same = iterations[0] == iterations[1];
+        for (int k = 0; same && k < iterations[0] - 1; ++k){
+            same = bounds[0][k] == bounds[1][k];
+#if !TT_ENABLED
+            same = same && nodes[0][k] == nodes[1][k];
+#endif
+        }
+#if SOLVER_WEIGHT == 10
+        same = same && length[0] == length[1];
+#endif
+        CHECK(same, "board %llx searched in move order differs from closest first", board_key(board));
+    }
+    hint_ordered = true;
+}
+
+
+#if PDB_ENABLED
+int pattern_manhattan(int pattern[]){
+    int distance = 0;
+    for (int i = 1; i <= PDB_TILES; ++i){
+        distance += tile_distance(i, pattern[i]);
+    }
+    return distance;
+}
+
+
+// with no table to walk down, the pattern's manhattan distance is returned
+void test_pdb_unbuilt(){
+    int board[TILE_dimension*TILE_dimension];
+    int pattern[PDB_TILES + 1];
+    for (int i = 0; i < 100; ++i){
+        solvable_board(board);
+        pdb_pattern(board, pattern);
+        CHECK(pdb_distance(pattern) == pattern_manhattan(pattern), "unbuilt pattern database did not fall back to manhattan");
+    }
+}
+
+
+// the pattern distance lies between its manhattan distance and the exact one
+void test_pdb(){
+    int board[TILE_dimension*TILE_dimension];
+    int pattern[PDB_TILES + 1];
+    for (int i = 0; i < RANDOM_BOARDS; ++i){
+        solvable_board(board);
+        pdb_pattern(board, pattern);
+        int distance = pdb_distance(pattern);
+        CHECK(distance >= pattern_manhattan(pattern), "pattern distance %d under manhattan %d", distance, pattern_manhattan(pattern));
+#if HINT_TABLE_ENABLED
+        CHECK(distance <= hint_table_distance(board), "pattern distance %d over the exact %d", distance, hint_table_distance(board));
+#endif
+    }
+}
+#endif
+
+
+int main(){
+    void* mmio = mmap((void*) MMIO_BASE, MMIO_SPAN, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0);
+    if (mmio == MAP_FAILED){
+        perror("mmap of the MMIO page");
+        return 1;
+    }
+    srand(1);
+    distance_table_init();
+    session_pool_init();
+    solver_pool_init();
+    hint_solver = solver_create();
+#if PDB_ENABLED
+    test_pdb_unbuilt();
+    pdb_init();
+#endif
+#if HINT_TABLE_ENABLED
+    hint_table_init();
+    while (hint_table_step()); // the fake clock stands still, so one slice fills the table
+#endif
+
+    test_clock();
+    test_limits();
+    test_stats();
+    test_history();
+    test_solver();
+    test_hints();
+    test_corpus();
+    test_leaderboard();
+    test_ranks();
+    test_child_order();
+    test_validate();
+    test_mouse();
+#if PDB_ENABLED
+    test_pdb();
+#endif
+
+    printf("%d of %d checks failed\n", failures, checks);
+    return failures;
+}
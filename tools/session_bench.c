@@ -0,0 +1,147 @@
+// allocation rate and memory of the game_session pool on a PC, with a pool
+// big enough for 1M simulated sessions. Built like tests/host_test.c, the
+// game is included with its device registers mapped as plain memory:
+//
+//     gcc -O2 -Wall -o session_bench tools/session_bench.c && ./session_bench
+//
+// Every session gets a random board and a few moves, then games end and new
+// ones start in their slots as shuffle() does. Prints a table and a JSON line.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+
+#define MAX_SESSIONS          1000000       // sessions live at once, all from the pool
+
+#define asm(...)
+#define interrupt
+#define main game_main
+// with the assembly compiled out the PSR values it took are unused, and the
+// 32 bit register addresses are cast to 64 bit pointers
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-variable"
+#pragma GCC diagnostic ignored "-Wunused-but-set-variable"
+#pragma GCC diagnostic ignored "-Wint-to-pointer-cast"
+#include "../15-puzzle-game.c"
+#pragma GCC diagnostic pop
+#undef main
+
+#define MMIO_BASE             0xFF200000    // lightweight bridge devices, timer at TIMER_BASE
+#define MMIO_SPAN             0x10000
+#define BENCH_RECYCLES        1000000       // games ended and restarted after the pool is full
+#define BENCH_MOVES           8             // moves played in every game
+#define BENCH_SEED            1
+
+// counts every heap allocation, sessions must not make any
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t count, size_t size);
+extern void* __libc_realloc(void* pointer, size_t size);
+unsigned long long allocations = 0;
+
+void* malloc(size_t size){
+    allocations++;
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size){
+    allocations++;
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* pointer, size_t size){
+    allocations++;
+    return __libc_realloc(pointer, size);
+}
+
+struct game_session* live[MAX_SESSIONS];
+
+double wall_seconds();
+long peak_rss_kb(); // high water mark of the resident set
+void start_game(struct game_session* s); // random board, then BENCH_MOVES moves
+
+
+double wall_seconds(){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec/1e9;
+}
+
+
+long peak_rss_kb(){
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+
+// the moves go through session_select() and session_move(), like the keys
+void start_game(struct game_session* s){
+    int board[TILE_dimension*TILE_dimension];
+    random_board(board);
+    new_game_board(s, board);
+    session_reset_selection(s);
+    for (int i = 0; i < BENCH_MOVES; ++i){
+        session_select(s, 1 + rand() % 3);
+        session_move(s);
+    }
+}
+
+
+int main(){
+    void* mmio = mmap((void*) MMIO_BASE, MMIO_SPAN, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0);
+    if (mmio == MAP_FAILED){
+        perror("mmap");
+        return 1;
+    }
+    srand(BENCH_SEED);
+    distance_table_init();
+    long start_rss_kb = peak_rss_kb();
+
+    // every slot is written once here, so the pool is resident from now on
+    session_pool_init();
+    long pool_rss_kb = peak_rss_kb();
+
+    unsigned long long start_allocations = allocations;
+    double start = wall_seconds();
+    for (int i = 0; i < MAX_SESSIONS; ++i){
+        live[i] = session_alloc();
+        start_game(live[i]);
+    }
+    double fill_seconds = wall_seconds() - start;
+    unsigned long long fill_allocations = allocations - start_allocations;
+    bool full = session_alloc() == NULL;
+    long fill_rss_kb = peak_rss_kb();
+
+    // games end in random slots while the rest stay live
+    start_allocations = allocations;
+    start = wall_seconds();
+    for (int i = 0; i < BENCH_RECYCLES; ++i){
+        int slot = rand() % MAX_SESSIONS;
+        live[slot] = session_recycle(live[slot]);
+        start_game(live[slot]);
+    }
+    double recycle_seconds = wall_seconds() - start;
+    unsigned long long recycle_allocations = allocations - start_allocations;
+    long recycle_rss_kb = peak_rss_kb();
+
+    printf("phase        sessions    sessions/s  allocations  peak RSS KB\n");
+    printf("pool init    %8d %13s %12s %12ld\n", MAX_SESSIONS, "", "", pool_rss_kb);
+    printf("fill         %8d %13.0f %12llu %12ld\n", MAX_SESSIONS, MAX_SESSIONS/fill_seconds,
+           fill_allocations, fill_rss_kb);
+    printf("recycle      %8d %13.0f %12llu %12ld\n", BENCH_RECYCLES, BENCH_RECYCLES/recycle_seconds,
+           recycle_allocations, recycle_rss_kb);
+    printf("%zu bytes per session, %ld KB before the pool, pool %s at %d sessions\n",
+           sizeof(struct game_session), start_rss_kb, full ? "empty" : "NOT empty", MAX_SESSIONS);
+    printf("{\"sessions\":%d,\"recycles\":%d,\"moves\":%d,\"session_bytes\":%zu,"
+           "\"fill_per_s\":%.0f,\"recycle_per_s\":%.0f,\"fill_allocations\":%llu,\"recycle_allocations\":%llu,"
+           "\"rss_start_kb\":%ld,\"rss_pool_kb\":%ld,\"rss_fill_kb\":%ld,\"rss_recycle_kb\":%ld}\n",
+           MAX_SESSIONS, BENCH_RECYCLES, BENCH_MOVES, sizeof(struct game_session),
+           MAX_SESSIONS/fill_seconds, BENCH_RECYCLES/recycle_seconds, fill_allocations, recycle_allocations,
+           start_rss_kb, pool_rss_kb, fill_rss_kb, recycle_rss_kb);
+    return !full || fill_allocations != 0 || recycle_allocations != 0;
+}
@@ -0,0 +1,498 @@
+// game server on a PC: many sessions played over TCP by a fixed pool of
+// worker threads, with the moves of swap_tile() and select_new_selected_tile()
+// and the time and move limits of counter(). Built like tests/host_test.c:
+//
+//     gcc -O2 -Wall -pthread -o session_server tools/session_server.c
+//     ./session_server [port]                 serve on 127.0.0.1, SERVER_PORT by default
+//     ./session_server load [connections]     serve and load it over loopback, prints moves/s
+//
+// Requests and replies are 4 bytes. A connection plays up to
+// CONNECTION_SESSIONS sessions, numbered from 0, and the worker that owns the
+// connection is the only thread touching them; only the pool is shared.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+
+#define MAX_SESSIONS          65536         // sessions live at once over all connections
+
+#define asm(...)
+#define interrupt
+#define main game_main
+// with the assembly compiled out the PSR values it took are unused, and the
+// 32 bit register addresses are cast to 64 bit pointers
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-variable"
+#pragma GCC diagnostic ignored "-Wunused-but-set-variable"
+#pragma GCC diagnostic ignored "-Wint-to-pointer-cast"
+#include "../15-puzzle-game.c"
+#pragma GCC diagnostic pop
+#undef main
+
+#define MMIO_BASE             0xFF200000    // lightweight bridge devices, timer at TIMER_BASE
+#define MMIO_SPAN             0x10000
+#define SERVER_PORT           15015
+#define MAX_CONNECTIONS       1024
+#define MAX_WORKERS           64            // worker threads, one per core up to this
+#define CONNECTION_SESSIONS   256           // sessions one connection can play at once
+#define CONNECTION_BUFFER     4096          // bytes of requests read at a time, a multiple of 4
+
+// requests: op, argument, session number (little endian 16 bits)
+#define OP_NEW                0             // new random board in the session, replaces a game there
+#define OP_SELECT             1             // argument 0 selects the next tile, 1 the previous, as the arrow keys
+#define OP_MOVE               2             // slide the selected tile, as Enter
+#define OP_END                3             // free the session
+
+// replies: status, selected tile position, moves (little endian 16 bits)
+#define REPLY_OK              0
+#define REPLY_REFUSED         1             // the selected tile cannot slide or the game is over
+#define REPLY_SOLVED          2             // this move solved the board
+#define REPLY_LIMIT           3             // out of time or moves, the game is over
+#define REPLY_ERROR           4             // no such session, or the pool is empty
+
+#define LOAD_CONNECTIONS      64            // default connections of the load generator
+#define LOAD_SESSIONS         64            // sessions per load connection
+#define LOAD_SECONDS          5
+#define LOAD_SEED             1
+
+struct connection {
+    int fd; // -1 while the slot is unused
+    int worker;
+    struct game_session* sessions[CONNECTION_SESSIONS];
+    unsigned char input[CONNECTION_BUFFER];
+    int input_length; // bytes of a request not yet complete
+};
+
+struct worker {
+    pthread_t thread;
+    int epoll_fd;
+    unsigned int tick; // clock_periods at the last deadline sweep
+};
+
+struct load_client {
+    pthread_t thread;
+    unsigned long long moves; // moves the server made
+    unsigned long long games; // games started
+};
+
+// server
+int server_listen(int port); // listening socket on 127.0.0.1, port 0 picks one
+void server_start(int listen_fd); // timer, workers and the accepting thread
+void* timer_thread(void* argument); // the interval timer: one interval_timer_ISR() per period
+void* accept_thread(void* argument);
+void* worker_thread(void* argument);
+struct connection* connection_open(int fd, int worker);
+void connection_close(struct connection* c);
+void connection_sweep(struct worker* w); // sets the limit flag of sessions whose time is up
+void connection_request(struct connection* c, const unsigned char request[4], unsigned char reply[4]);
+bool write_all(int fd, const unsigned char* data, int length);
+bool read_all(int fd, unsigned char* data, int length);
+
+// load generator
+void load_run(int port, int connections_count);
+void* load_thread(void* argument);
+
+pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER; // session pool and connection slots
+struct connection connections[MAX_CONNECTIONS];
+struct worker workers[MAX_WORKERS];
+int worker_count;
+struct load_client load_clients[MAX_CONNECTIONS];
+volatile bool load_stop = false;
+int load_port;
+
+
+int server_listen(int port){
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(port);
+    if (bind(fd, (struct sockaddr*) &address, sizeof(address)) != 0 || listen(fd, SOMAXCONN) != 0){
+        perror("listen");
+        exit(1);
+    }
+    return fd;
+}
+
+
+void server_start(int listen_fd){
+    for (int i = 0; i < MAX_CONNECTIONS; ++i){
+        connections[i].fd = -1;
+    }
+    worker_count = sysconf(_SC_NPROCESSORS_ONLN);
+    if (worker_count < 1){
+        worker_count = 1;
+    } else if (worker_count > MAX_WORKERS){
+        worker_count = MAX_WORKERS;
+    }
+    pthread_t thread;
+    pthread_create(&thread, NULL, timer_thread, NULL);
+    for (int i = 0; i < worker_count; ++i){
+        workers[i].epoll_fd = epoll_create1(0);
+        workers[i].tick = clock_periods;
+        pthread_create(&workers[i].thread, NULL, worker_thread, &workers[i]);
+    }
+    static int accept_fd;
+    accept_fd = listen_fd;
+    pthread_create(&thread, NULL, accept_thread, &accept_fd);
+}
+
+
+// the game's clock only moves when the ISR counts a period, so the server
+// ticks it the same way and the limits behave as on the board
+void* timer_thread(void* argument){
+    struct timespec period = {TIMER_MS_PER_PERIOD/1000, TIMER_MS_PER_PERIOD%1000*1000000L};
+    while (true){
+        nanosleep(&period, NULL);
+        interval_timer_ISR();
+    }
+    return NULL;
+}
+
+
+// connections are dealt to the workers in turn
+void* accept_thread(void* argument){
+    int listen_fd = *(int*) argument;
+    int next = 0;
+    while (true){
+        int fd = accept(listen_fd, NULL, NULL);
+        if (fd < 0){
+            continue;
+        }
+        int on = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        struct connection* c = connection_open(fd, next);
+        if (c == NULL){
+            close(fd);
+            continue;
+        }
+        struct epoll_event event;
+        event.events = EPOLLIN;
+        event.data.ptr = c;
+        epoll_ctl(workers[next].epoll_fd, EPOLL_CTL_ADD, fd, &event);
+        next = (next + 1) % worker_count;
+    }
+    return NULL;
+}
+
+
+// every complete request read is answered in one write, so a client sending
+// a batch gets one batch of replies back
+void* worker_thread(void* argument){
+    struct worker* w = argument;
+    struct epoll_event events[64];
+    static __thread unsigned char replies[CONNECTION_BUFFER];
+    while (true){
+        int ready = epoll_wait(w->epoll_fd, events, 64, TIMER_MS_PER_PERIOD);
+        if (w->tick != clock_periods){
+            w->tick = clock_periods;
+            connection_sweep(w);
+        }
+        for (int e = 0; e < ready; ++e){
+            struct connection* c = events[e].data.ptr;
+            int length = read(c->fd, c->input + c->input_length, CONNECTION_BUFFER - c->input_length);
+            if (length <= 0){
+                if (length < 0 && errno == EINTR){
+                    continue;
+                }
+                epoll_ctl(w->epoll_fd, EPOLL_CTL_DEL, c->fd, NULL);
+                connection_close(c);
+                continue;
+            }
+            length += c->input_length;
+            int complete = length & ~3;
+            for (int i = 0; i < complete; i += 4){
+                connection_request(c, c->input + i, replies + i);
+            }
+            c->input_length = length - complete;
+            memmove(c->input, c->input + complete, c->input_length);
+            if (!write_all(c->fd, replies, complete)){
+                epoll_ctl(w->epoll_fd, EPOLL_CTL_DEL, c->fd, NULL);
+                connection_close(c);
+            }
+        }
+    }
+    return NULL;
+}
+
+
+struct connection* connection_open(int fd, int worker){
+    struct connection* c = NULL;
+    pthread_mutex_lock(&pool_lock);
+    for (int i = 0; i < MAX_CONNECTIONS; ++i){
+        if (connections[i].fd < 0){
+            c = &connections[i];
+            c->fd = fd;
+            c->worker = worker;
+            c->input_length = 0;
+            memset(c->sessions, 0, sizeof(c->sessions));
+            break;
+        }
+    }
+    pthread_mutex_unlock(&pool_lock);
+    return c;
+}
+
+
+void connection_close(struct connection* c){
+    close(c->fd);
+    pthread_mutex_lock(&pool_lock);
+    for (int i = 0; i < CONNECTION_SESSIONS; ++i){
+        if (c->sessions[i] != NULL){
+            session_free(c->sessions[i]);
+        }
+    }
+    c->fd = -1;
+    pthread_mutex_unlock(&pool_lock);
+}
+
+
+// what interval_timer_ISR() does for the game on the VGA, for every session
+// of the worker's connections; the lock keeps the slots still while another
+// worker or the accepting thread opens or closes its own
+void connection_sweep(struct worker* w){
+    unsigned int now_ms = w->tick*TIMER_MS_PER_PERIOD;
+    pthread_mutex_lock(&pool_lock);
+    for (int i = 0; i < MAX_CONNECTIONS; ++i){
+        struct connection* c = &connections[i];
+        if (c->fd < 0 || c->worker != w - workers){
+            continue;
+        }
+        for (int j = 0; j < CONNECTION_SESSIONS; ++j){
+            if (c->sessions[j] != NULL){
+                session_check_deadline(c->sessions[j], now_ms);
+            }
+        }
+    }
+    pthread_mutex_unlock(&pool_lock);
+}
+
+
+void connection_request(struct connection* c, const unsigned char request[4], unsigned char reply[4]){
+    int op = request[0];
+    int number = request[2] | request[3] << 8;
+    int status = REPLY_OK;
+    struct game_session* s = number < CONNECTION_SESSIONS ? c->sessions[number] : NULL;
+
+    if (number >= CONNECTION_SESSIONS || (s == NULL && op != OP_NEW)){
+        status = REPLY_ERROR;
+    } else if (op == OP_NEW){
+        // a game ending here starts the next one in its slot, as shuffle() does
+        pthread_mutex_lock(&pool_lock);
+        s = s != NULL ? session_recycle(s) : session_alloc();
+        pthread_mutex_unlock(&pool_lock);
+        c->sessions[number] = s;
+        if (s == NULL){
+            status = REPLY_ERROR;
+        } else {
+            int board[TILE_dimension*TILE_dimension];
+            random_board(board);
+            new_game_board(s, board);
+            game_clock_reset(s);
+            session_reset_selection(s);
+        }
+    } else if (op == OP_SELECT){
+        session_select(s, request[1] ? 1 : -1);
+    } else if (op == OP_MOVE){
+        // counter() ends a game that is out of time or moves before the next key
+        if (session_limit_reached(s)){
+            game_clock_pause(s);
+            s->game_over = true;
+            status = REPLY_LIMIT;
+        } else if (!session_move(s)){
+            status = REPLY_REFUSED;
+        } else if (s->game_over){
+            status = REPLY_SOLVED;
+        } else if (session_limit_reached(s)){
+            game_clock_pause(s);
+            s->game_over = true;
+            status = REPLY_LIMIT;
+        }
+    } else if (op == OP_END){
+        pthread_mutex_lock(&pool_lock);
+        session_free(s);
+        pthread_mutex_unlock(&pool_lock);
+        c->sessions[number] = NULL;
+        s = NULL;
+    } else {
+        status = REPLY_ERROR;
+    }
+
+    reply[0] = status;
+    reply[1] = s != NULL ? s->selected_tile_position : NO_TILE;
+    reply[2] = s != NULL ? s->moves & 0xFF : 0;
+    reply[3] = s != NULL ? s->moves >> 8 & 0xFF : 0;
+}
+
+
+bool write_all(int fd, const unsigned char* data, int length){
+    while (length > 0){
+        int written = write(fd, data, length);
+        if (written < 0){
+            if (errno == EINTR){
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        length -= written;
+    }
+    return true;
+}
+
+
+bool read_all(int fd, unsigned char* data, int length){
+    while (length > 0){
+        int got = read(fd, data, length);
+        if (got <= 0){
+            if (got < 0 && errno == EINTR){
+                continue;
+            }
+            return false;
+        }
+        data += got;
+        length -= got;
+    }
+    return true;
+}
+
+
+// each client sends one batch per round, a select and a move for every one
+// of its sessions, and starts a new game wherever the last one ended
+void* load_thread(void* argument){
+    struct load_client* client = argument;
+    static __thread unsigned char batch[LOAD_SESSIONS*2*4];
+    static __thread unsigned char replies[LOAD_SESSIONS*2*4];
+    bool ended[LOAD_SESSIONS];
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    int on = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(load_port);
+    if (connect(fd, (struct sockaddr*) &address, sizeof(address)) != 0){
+        perror("connect");
+        return NULL;
+    }
+    for (int i = 0; i < LOAD_SESSIONS; ++i){
+        ended[i] = true;
+    }
+
+    unsigned int seed = LOAD_SEED + (client - load_clients);
+    while (!load_stop){
+        int length = 0;
+        for (int i = 0; i < LOAD_SESSIONS; ++i){
+            unsigned char* request = batch + length;
+            request[0] = ended[i] ? OP_NEW : OP_SELECT;
+            request[1] = rand_r(&seed) % 2;
+            request[2] = i & 0xFF;
+            request[3] = i >> 8;
+            request[4] = OP_MOVE;
+            request[5] = 0;
+            request[6] = i & 0xFF;
+            request[7] = i >> 8;
+            length += 8;
+        }
+        if (!write_all(fd, batch, length) || !read_all(fd, replies, length)){
+            break;
+        }
+        for (int i = 0; i < LOAD_SESSIONS; ++i){
+            int status = replies[8*i + 4];
+            ended[i] = status == REPLY_SOLVED || status == REPLY_LIMIT || replies[8*i] == REPLY_ERROR;
+            client->games += batch[8*i] == OP_NEW;
+            client->moves += status == REPLY_OK || status == REPLY_SOLVED;
+        }
+    }
+    close(fd);
+    return NULL;
+}
+
+
+// client and server share the process, so the CPU time is what both used
+void load_run(int port, int connections_count){
+    struct load_client* clients = load_clients;
+    if (connections_count > MAX_CONNECTIONS){
+        connections_count = MAX_CONNECTIONS;
+    }
+    load_port = port;
+    struct rusage before;
+    getrusage(RUSAGE_SELF, &before);
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < connections_count; ++i){
+        pthread_create(&clients[i].thread, NULL, load_thread, &clients[i]);
+    }
+    sleep(LOAD_SECONDS);
+    load_stop = true;
+    unsigned long long moves = 0;
+    unsigned long long games = 0;
+    for (int i = 0; i < connections_count; ++i){
+        pthread_join(clients[i].thread, NULL);
+        moves += clients[i].moves;
+        games += clients[i].games;
+    }
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    struct rusage after;
+    getrusage(RUSAGE_SELF, &after);
+
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec)/1e9;
+    double cpu_seconds = (after.ru_utime.tv_sec - before.ru_utime.tv_sec) + (after.ru_utime.tv_usec - before.ru_utime.tv_usec)/1e6 +
+                         (after.ru_stime.tv_sec - before.ru_stime.tv_sec) + (after.ru_stime.tv_usec - before.ru_stime.tv_usec)/1e6;
+    int sessions = connections_count*LOAD_SESSIONS;
+    printf("%d connections, %d sessions, %d workers, %llu games, %llu moves in %.1f s\n",
+           connections_count, sessions, worker_count, games, moves, seconds);
+    printf("%.0f moves/s, %.0f moves per CPU second (client and server)\n", moves/seconds, moves/cpu_seconds);
+    printf("{\"connections\":%d,\"sessions\":%d,\"workers\":%d,\"games\":%llu,\"moves\":%llu,"
+           "\"seconds\":%.2f,\"moves_per_s\":%.0f,\"moves_per_cpu_s\":%.0f}\n",
+           connections_count, sessions, worker_count, games, moves, seconds, moves/seconds, moves/cpu_seconds);
+}
+
+
+int main(int argc, char* argv[]){
+    void* mmio = mmap((void*) MMIO_BASE, MMIO_SPAN, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0);
+    if (mmio == MAP_FAILED){
+        perror("mmap");
+        return 1;
+    }
+    srand(LOAD_SEED);
+    distance_table_init();
+    session_pool_init();
+    game_mode_select(GAME_MODE_DEFAULT);
+
+    bool load = argc > 1 && strcmp(argv[1], "load") == 0;
+    int port = !load && argc > 1 ? atoi(argv[1]) : load ? 0 : SERVER_PORT;
+    int listen_fd = server_listen(port);
+    struct sockaddr_in address;
+    socklen_t address_length = sizeof(address);
+    getsockname(listen_fd, (struct sockaddr*) &address, &address_length);
+    server_start(listen_fd);
+
+    if (load){
+        load_run(ntohs(address.sin_port), argc > 2 ? atoi(argv[2]) : LOAD_CONNECTIONS);
+        return 0;
+    }
+    printf("serving on 127.0.0.1:%d\n", ntohs(address.sin_port));
+    while (true){
+        pause();
+    }
+}